@@ -0,0 +1,122 @@
+"use strict";
+
+// Micro-benchmark for per-call overhead of the binding, and for worker start-up with shared programs.
+//
+// It is not a part of the test suite. Build the addon, and run it from the project root:
+//
+//     node bench/calls.js [iterations]
+//
+// The first part calls methods with short subjects, where the matching itself is cheap,
+// so timings are dominated by crossing the JavaScript/native boundary. RegExp is shown as a reference.
+// The second part starts workers, which create the same set of patterns: compiling them in every worker,
+// or wrapping programs shared by the main thread.
+
+var RE2 = require("../re2");
+
+
+var iterations = +process.argv[2] || 1000000, sink = 0;
+
+function pad(name) {
+	return "  " + (name + ":                              ").slice(0, 32);
+}
+
+function measure(name, fn) {
+	fn(1000); // warm up
+	var start = process.hrtime();
+	sink += fn(iterations); // results are used, so loops are not optimized away
+	var diff = process.hrtime(start);
+	console.log(pad(name) + ((diff[0] * 1e9 + diff[1]) / iterations).toFixed(1) + " ns/call");
+}
+
+function callOverhead() {
+	var subjects = ["GET /index.html HTTP/1.1", "content-type: application/json", "x-request-id: 12345", "accept: */*"],
+		sources = ["^content-type:", "\\d{5}"];
+
+	sources.forEach(function (source) {
+		var re2 = new RE2(source), re = new RegExp(source);
+		console.log("/" + source + "/");
+		measure("RE2#test", function (n) {
+			var count = 0;
+			for (var i = 0; i < n; ++i) if (re2.test(subjects[i & 3])) ++count;
+			return count;
+		});
+		measure("RegExp#test", function (n) {
+			var count = 0;
+			for (var i = 0; i < n; ++i) if (re.test(subjects[i & 3])) ++count;
+			return count;
+		});
+		measure("RE2#search", function (n) {
+			var sum = 0;
+			for (var i = 0; i < n; ++i) sum += re2.search(subjects[i & 3]);
+			return sum;
+		});
+		measure("RE2#exec", function (n) {
+			var count = 0;
+			for (var i = 0; i < n; ++i) if (re2.exec(subjects[i & 3])) ++count;
+			return count;
+		});
+		measure("RE2#test (buffer)", function (n) {
+			var buffers = subjects.map(function (s) { return Buffer.from(s); }), count = 0;
+			for (var i = 0; i < n; ++i) if (re2.test(buffers[i & 3])) ++count;
+			return count;
+		});
+	});
+}
+
+function workerStartup(done) {
+	var workers;
+	try {
+		workers = require("worker_threads");
+	} catch (e) {
+		console.log("worker threads are not available");
+		done();
+		return;
+	}
+
+	var patterns = [];
+	for (var i = 0; i < 2000; ++i) {
+		patterns.push("(?i)header-" + i + "-(\\w+)\\s*:\\s*([^;]+);?");
+	}
+	// programs are shared, while the main thread keeps its objects
+	var originals = patterns.map(function (p) { return new RE2(p); }),
+		handles   = originals.map(function (re) { return re.share(); });
+
+	// the cache is process-wide: without it every worker compiles patterns
+	RE2.cacheCapacity = 0;
+
+	var code =
+		"var RE2 = require(" + JSON.stringify(require.resolve("../re2")) + ");" +
+		"var wt = require('worker_threads'), data = wt.workerData, start = process.hrtime();" +
+		"var list = data.items.map(function (x) { return new RE2(x); });" +
+		"var diff = process.hrtime(start);" +
+		"wt.parentPort.postMessage(diff[0] * 1e3 + diff[1] / 1e6);";
+
+	function run(name, items, count, next) {
+		var start = process.hrtime(), times = [], left = count;
+		for (var i = 0; i < count; ++i) {
+			var worker = new workers.Worker(code, {eval: true, workerData: {items: items}});
+			worker.on("message", function (ms) {
+				times.push(ms);
+				if (!--left) {
+					var diff = process.hrtime(start);
+					console.log(pad(name) + (diff[0] * 1e3 + diff[1] / 1e6).toFixed(1) + " ms total, " +
+						Math.max.apply(Math, times).toFixed(1) + " ms slowest worker");
+					next();
+				}
+			});
+		}
+	}
+
+	var count = require("os").cpus().length;
+	console.log(count + " workers create " + patterns.length + " patterns");
+	run("compile in every worker", patterns, count, function () {
+		run("share() from the main thread", handles, count, function () {
+			done(originals.length);
+		});
+	});
+}
+
+
+console.log("call overhead, " + iterations + " iterations");
+callOverhead();
+workerStartup(function (n) { sink += n; });
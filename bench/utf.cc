@@ -0,0 +1,189 @@
+// Micro-benchmark for UTF-8/UTF-16 length kernels in lib/utf.cc.
+//
+// It is not a part of the addon. Build and run it from the project root:
+//
+//     g++ -std=c++11 -O3 -o utf_bench bench/utf.cc lib/utf.cc && ./utf_bench
+
+#include "../lib/utf.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+using std::string;
+using std::vector;
+
+
+// the original byte-at-a-time implementations, used as a baseline
+
+static size_t getUtf8LengthOriginal(const uint16_t* from, const uint16_t* to) {
+	size_t n = 0;
+	while (from != to) {
+		uint16_t ch = *from++;
+		if (ch <= 0x7F) ++n;
+		else if (ch <= 0x7FF) n += 2;
+		else if (0xD800 <= ch && ch <= 0xDFFF) {
+			n += 4;
+			if (from == to) break;
+			++from;
+		}
+		else if (ch < 0xFFFF) n += 3;
+		else n += 4;
+	}
+	return n;
+}
+
+static size_t getUtf16LengthOriginal(const char* from, const char* to) {
+	size_t n = 0;
+	while (from != to) {
+		unsigned ch = *from & 0xFF;
+		if (ch < 0xF0) {
+			if (ch < 0x80) {
+				++from;
+			} else {
+				if (ch < 0xE0) {
+					from += 2;
+					if (from == to + 1) {
+						++n;
+						break;
+					}
+				} else {
+					from += 3;
+					if (from > to && from < to + 3) {
+						++n;
+						break;
+					}
+				}
+			}
+			++n;
+		} else {
+			from += 4;
+			n += 2;
+			if (from > to && from < to + 4) break;
+		}
+	}
+	return n;
+}
+
+static bool isAsciiOriginal(const char* from, const char* to) {
+	for (; from != to; ++from) {
+		if (*from & 0x80) return false;
+	}
+	return true;
+}
+
+
+// corpora
+
+struct Corpus {
+	const char*      name;
+	string           utf8;
+	vector<uint16_t> utf16;
+};
+
+static void appendCodePoint(Corpus& corpus, unsigned cp) {
+	string& s = corpus.utf8;
+	if (cp < 0x80) {
+		s += static_cast<char>(cp);
+	} else if (cp < 0x800) {
+		s += static_cast<char>(0xC0 | (cp >> 6));
+		s += static_cast<char>(0x80 | (cp & 0x3F));
+	} else if (cp < 0x10000) {
+		s += static_cast<char>(0xE0 | (cp >> 12));
+		s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		s += static_cast<char>(0x80 | (cp & 0x3F));
+	} else {
+		s += static_cast<char>(0xF0 | (cp >> 18));
+		s += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+		s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		s += static_cast<char>(0x80 | (cp & 0x3F));
+	}
+	if (cp < 0x10000) {
+		corpus.utf16.push_back(static_cast<uint16_t>(cp));
+	} else {
+		cp -= 0x10000;
+		corpus.utf16.push_back(static_cast<uint16_t>(0xD800 + (cp >> 10)));
+		corpus.utf16.push_back(static_cast<uint16_t>(0xDC00 + (cp & 0x3FF)));
+	}
+}
+
+// every 8th character is taken from `other`, the rest are ASCII letters or spaces
+static Corpus makeCorpus(const char* name, unsigned otherFrom, unsigned otherTo, unsigned ratio, size_t size) {
+	Corpus corpus;
+	corpus.name = name;
+	unsigned seed = 12345;
+	while (corpus.utf8.size() < size) {
+		seed = seed * 1103515245 + 12345;
+		unsigned r = seed >> 8;
+		if (otherTo > otherFrom && r % 8 < ratio) {
+			appendCodePoint(corpus, otherFrom + r % (otherTo - otherFrom));
+		} else {
+			appendCodePoint(corpus, r % 6 ? 'a' + r % 26 : ' ');
+		}
+	}
+	return corpus;
+}
+
+
+// timing
+
+template<typename F>
+static double measure(F f, size_t bytes) {
+	double best = 1e100;
+	for (int i = 0; i < 7; ++i) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		f();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (best > seconds) best = seconds;
+	}
+	return bytes / best / (1024 * 1024);
+}
+
+static volatile size_t sink;
+
+
+int main() {
+	const size_t size = 16 * 1024 * 1024;
+
+	vector<Corpus> corpora;
+	corpora.push_back(makeCorpus("ascii", 0, 0, 0, size));
+	corpora.push_back(makeCorpus("latin", 0xC0, 0x180, 1, size));
+	corpora.push_back(makeCorpus("cjk", 0x4E00, 0x9FA0, 6, size));
+	corpora.push_back(makeCorpus("emoji", 0x1F600, 0x1F650, 3, size));
+
+	printf("%-8s %-16s %12s %12s %8s\n", "corpus", "kernel", "original", "current", "speedup");
+
+	for (size_t i = 0; i < corpora.size(); ++i) {
+		const Corpus& c = corpora[i];
+		const char *from8 = c.utf8.data(), *to8 = from8 + c.utf8.size();
+		const uint16_t *from16 = &c.utf16[0], *to16 = from16 + c.utf16.size();
+
+		if (getUtf16Length(from8, to8) != getUtf16LengthOriginal(from8, to8) ||
+				getUtf8Length(from16, to16) != getUtf8LengthOriginal(from16, to16) ||
+				isAscii(from8, to8) != isAsciiOriginal(from8, to8)) {
+			printf("%s: MISMATCH\n", c.name);
+			return 1;
+		}
+
+		double a, b;
+
+		a = measure([&]() { sink = getUtf16LengthOriginal(from8, to8); }, c.utf8.size());
+		b = measure([&]() { sink = getUtf16Length(from8, to8); }, c.utf8.size());
+		printf("%-8s %-16s %7.0f MB/s %7.0f MB/s %7.1fx\n", c.name, "getUtf16Length", a, b, b / a);
+
+		a = measure([&]() { sink = getUtf8LengthOriginal(from16, to16); }, c.utf16.size() * 2);
+		b = measure([&]() { sink = getUtf8Length(from16, to16); }, c.utf16.size() * 2);
+		printf("%-8s %-16s %7.0f MB/s %7.0f MB/s %7.1fx\n", c.name, "getUtf8Length", a, b, b / a);
+
+		// non-ASCII corpora stop at the first non-ASCII character
+		if (isAsciiOriginal(from8, to8)) {
+			a = measure([&]() { sink = isAsciiOriginal(from8, to8); }, c.utf8.size());
+			b = measure([&]() { sink = isAscii(from8, to8); }, c.utf8.size());
+			printf("%-8s %-16s %7.0f MB/s %7.0f MB/s %7.1fx\n", c.name, "isAscii", a, b, b / a);
+		}
+	}
+
+	return 0;
+}
@@ -4,17 +4,33 @@
       "target_name": "re2",
       "sources": [
         "lib/addon.cc",
+        "lib/environment.cc",
         "lib/new.cc",
         "lib/console.cc",
         "lib/exec.cc",
+        "lib/exec_into.cc",
+        "lib/exec_lazy.cc",
         "lib/test.cc",
+        "lib/fast_calls.cc",
         "lib/match.cc",
+        "lib/match_all.cc",
+        "lib/scanner.cc",
+        "lib/scan_file.cc",
         "lib/replace.cc",
         "lib/search.cc",
         "lib/split.cc",
+        "lib/many.cc",
+        "lib/match_all_parallel.cc",
+        "lib/async.cc",
         "lib/to_string.cc",
+        "lib/set.cc",
+        "lib/filtered_set.cc",
         "lib/accessors.cc",
         "lib/util.cc",
+        "lib/pattern_cache.cc",
+        "lib/share.cc",
+        "lib/stats.cc",
+        "lib/utf.cc",
         "vendor/re2/bitstate.cc",
         "vendor/re2/compile.cc",
         "vendor/re2/dfa.cc",
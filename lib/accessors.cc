@@ -1,4 +1,5 @@
 #include "./wrapped_re2.h"
+#include "./util.h"
 
 #include <cstring>
 #include <string>
@@ -28,7 +29,7 @@ NAN_GETTER(WrappedRE2::GetInternalSource) {
 	}
 
 	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
-	info.GetReturnValue().Set(Nan::New(re2->regexp.pattern()).ToLocalChecked());
+	info.GetReturnValue().Set(Nan::New(re2->regexp->pattern()).ToLocalChecked());
 }
 
 NAN_GETTER(WrappedRE2::GetFlags) {
@@ -38,23 +39,25 @@ NAN_GETTER(WrappedRE2::GetFlags) {
 	}
 
 	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	info.GetReturnValue().Set(Nan::New(re2->getFlags()).ToLocalChecked());
+}
 
+string WrappedRE2::getFlags() const {
 	string flags;
-	if (re2->global) {
+	if (global) {
 		flags = "g";
 	}
-	if (re2->ignoreCase) {
+	if (ignoreCase) {
 		flags += "i";
 	}
-	if (re2->multiline) {
+	if (multiline) {
 		flags += "m";
 	}
 	flags += "u";
-	if (re2->sticky) {
+	if (sticky) {
 		flags += "y";
 	}
-
-	info.GetReturnValue().Set(Nan::New(flags).ToLocalChecked());
+	return flags;
 }
 
 NAN_GETTER(WrappedRE2::GetGlobal) {
@@ -129,12 +132,46 @@ NAN_SETTER(WrappedRE2::SetLastIndex) {
 
 	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
 	if (value->IsNumber()) {
-		int n = value->NumberValue();
+		int n = value.As<v8::Number>()->Value();
 		re2->lastIndex = n <= 0 ? 0 : n;
 	}
 }
 
 
+NAN_GETTER(WrappedRE2::GetProgramSize) {
+	if (!WrappedRE2::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	info.GetReturnValue().Set(re2->regexp->ProgramSize());
+}
+
+
+NAN_GETTER(WrappedRE2::GetReverseProgramSize) {
+	if (!WrappedRE2::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	// the reverse program is compiled on demand, so this call can compile it
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	info.GetReturnValue().Set(re2->regexp->ReverseProgramSize());
+}
+
+
+NAN_GETTER(WrappedRE2::GetMaxMem) {
+	if (!WrappedRE2::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	info.GetReturnValue().Set(static_cast<double>(re2->regexp->options().max_mem()));
+}
+
+
 WrappedRE2::UnicodeWarningLevels WrappedRE2::unicodeWarningLevel;
 
 
@@ -160,9 +197,9 @@ NAN_GETTER(WrappedRE2::GetUnicodeWarningLevel) {
 
 NAN_SETTER(WrappedRE2::SetUnicodeWarningLevel) {
 	if (value->IsString()) {
-		Local<String> t(value->ToString());
-		vector<char> buffer(t->Utf8Length() + 1);
-		t->WriteUtf8(&buffer[0]);
+		Local<String> t(value.As<String>());
+		vector<char> buffer(utf8Length(t) + 1);
+		writeUtf8Chars(t, &buffer[0]);
 		if (!strcmp(&buffer[0], "throw")) {
 			unicodeWarningLevel = THROW;
 			return;
@@ -1,4 +1,10 @@
 #include "./wrapped_re2.h"
+#include "./wrapped_re2_set.h"
+#include "./wrapped_re2_filtered_set.h"
+#include "./wrapped_re2_match_iterator.h"
+#include "./wrapped_re2_scanner.h"
+#include "./lazy_result.h"
+#include "./util.h"
 
 #include <node_buffer.h>
 
@@ -12,8 +18,29 @@ using v8::String;
 using v8::Isolate;
 
 
-Nan::Persistent<Function>         WrappedRE2::constructor;
-Nan::Persistent<FunctionTemplate> WrappedRE2::ctorTemplate;
+// The addon is context-aware: it can be loaded by worker threads, and every worker has its own isolate
+// running on its own thread, so V8 handles are kept in thread-local statics, and released, when
+// an environment is torn down (see Environment). Compiled programs are immutable, and shared by all isolates
+// (see PatternCache and share()).
+
+thread_local Nan::Persistent<Function>         WrappedRE2::constructor;
+thread_local Nan::Persistent<FunctionTemplate> WrappedRE2::ctorTemplate;
+
+thread_local Nan::Persistent<Function>         WrappedRE2Set::constructor;
+thread_local Nan::Persistent<FunctionTemplate> WrappedRE2Set::ctorTemplate;
+
+thread_local Nan::Persistent<Function>         WrappedRE2FilteredSet::constructor;
+thread_local Nan::Persistent<FunctionTemplate> WrappedRE2FilteredSet::ctorTemplate;
+
+thread_local Nan::Persistent<Function>         WrappedRE2MatchIterator::constructor;
+thread_local Nan::Persistent<FunctionTemplate> WrappedRE2MatchIterator::ctorTemplate;
+
+thread_local Nan::Persistent<Function>         WrappedRE2Scanner::constructor;
+thread_local Nan::Persistent<FunctionTemplate> WrappedRE2Scanner::ctorTemplate;
+
+thread_local Nan::Persistent<ObjectTemplate>   LazyResult::resultTemplate;
+thread_local Nan::Persistent<ObjectTemplate>   LazyResult::groupsTemplate;
+thread_local Nan::Persistent<v8::Value>        LazyResult::arrayPrototype;
 
 
 static NAN_METHOD(GetUtf8Length) {
@@ -22,7 +49,7 @@ static NAN_METHOD(GetUtf8Length) {
 		return;
 	}
 	Local<String> s(t.ToLocalChecked());
-	info.GetReturnValue().Set(static_cast<int>(s->Utf8Length()));
+	info.GetReturnValue().Set(utf8Length(s));
 }
 
 
@@ -36,7 +63,7 @@ static NAN_METHOD(GetUtf16Length) {
 }
 
 
-void WrappedRE2::Initialize(Handle<Object> exports, Handle<Object> module) {
+void WrappedRE2::Initialize(Handle<Object> exports) {
 
 	// prepare constructor template
 	Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
@@ -48,13 +75,33 @@ void WrappedRE2::Initialize(Handle<Object> exports, Handle<Object> module) {
 	Nan::SetPrototypeMethod(tpl, "toString", ToString);
 
 	Nan::SetPrototypeMethod(tpl, "exec",     Exec);
-	Nan::SetPrototypeMethod(tpl, "test",     Test);
+	Nan::SetPrototypeMethod(tpl, "execInto", ExecInto);
+	Nan::SetPrototypeMethod(tpl, "execLazy", ExecLazy);
 
 	Nan::SetPrototypeMethod(tpl, "match",    Match);
+	Nan::SetPrototypeMethod(tpl, "matchAll", MatchAll);
 	Nan::SetPrototypeMethod(tpl, "replace",  Replace);
-	Nan::SetPrototypeMethod(tpl, "search",   Search);
 	Nan::SetPrototypeMethod(tpl, "split",    Split);
 
+	SetTestAndSearch(tpl);
+
+	Nan::SetPrototypeMethod(tpl, "testMany",   TestMany);
+	Nan::SetPrototypeMethod(tpl, "searchMany", SearchMany);
+	Nan::SetPrototypeMethod(tpl, "execMany",   ExecMany);
+
+	Nan::SetPrototypeMethod(tpl, "matchAllParallel", MatchAllParallel);
+
+	Nan::SetPrototypeMethod(tpl, "execAsync",     ExecAsync);
+	Nan::SetPrototypeMethod(tpl, "testAsync",     TestAsync);
+	Nan::SetPrototypeMethod(tpl, "matchAllAsync", MatchAllAsync);
+	Nan::SetPrototypeMethod(tpl, "replaceAsync",  ReplaceAsync);
+
+	Nan::SetPrototypeMethod(tpl, "createScanner", CreateScanner);
+
+	Nan::SetPrototypeMethod(tpl, "stats", GetStats);
+
+	Nan::SetPrototypeMethod(tpl, "share", Share);
+
 	Local<ObjectTemplate> proto = tpl->PrototypeTemplate();
 	Nan::SetAccessor(proto, Nan::New("source").ToLocalChecked(),         GetSource);
 	Nan::SetAccessor(proto, Nan::New("flags").ToLocalChecked(),          GetFlags);
@@ -65,22 +112,157 @@ void WrappedRE2::Initialize(Handle<Object> exports, Handle<Object> module) {
 	Nan::SetAccessor(proto, Nan::New("sticky").ToLocalChecked(),         GetSticky);
 	Nan::SetAccessor(proto, Nan::New("lastIndex").ToLocalChecked(),      GetLastIndex, SetLastIndex);
 	Nan::SetAccessor(proto, Nan::New("internalSource").ToLocalChecked(), GetInternalSource);
+	Nan::SetAccessor(proto, Nan::New("programSize").ToLocalChecked(),    GetProgramSize);
+	Nan::SetAccessor(proto, Nan::New("reverseProgramSize").ToLocalChecked(), GetReverseProgramSize);
+	Nan::SetAccessor(proto, Nan::New("maxMem").ToLocalChecked(),         GetMaxMem);
 
 	Local<Function> fun = Nan::GetFunction(tpl).ToLocalChecked();
 	Nan::Export(fun, "getUtf8Length",  GetUtf8Length);
 	Nan::Export(fun, "getUtf16Length", GetUtf16Length);
 	Nan::SetAccessor(Local<Object>(fun), Nan::New("unicodeWarningLevel").ToLocalChecked(), GetUnicodeWarningLevel, SetUnicodeWarningLevel);
+	Nan::Export(fun, "getCacheStats", GetCacheStats);
+	Nan::Export(fun, "clearCache",    ClearCache);
+	Nan::SetAccessor(Local<Object>(fun), Nan::New("cacheCapacity").ToLocalChecked(), GetCacheCapacity, SetCacheCapacity);
+	Nan::Export(fun, "stats", GetGlobalStats);
+	Nan::Export(fun, "scanFile",      ScanFile);
+	Nan::Export(fun, "scanFileAsync", ScanFileAsync);
+	Nan::SetAccessor(Local<Object>(fun), Nan::New("collectStats").ToLocalChecked(), GetCollectStats, SetCollectStats);
+	Nan::SetAccessor(Local<Object>(fun), Nan::New("slowMatchThreshold").ToLocalChecked(), GetSlowMatchThreshold, SetSlowMatchThreshold);
+	Nan::SetAccessor(Local<Object>(fun), Nan::New("onSlowMatch").ToLocalChecked(), GetOnSlowMatch, SetOnSlowMatch);
+	Nan::Set(fun, Nan::New("Set").ToLocalChecked(), WrappedRE2Set::Initialize());
+	Nan::Set(fun, Nan::New("FilteredSet").ToLocalChecked(), WrappedRE2FilteredSet::Initialize());
+	WrappedRE2MatchIterator::Initialize();
+	WrappedRE2Scanner::Initialize();
+	LazyResult::Initialize();
+	constructor.Reset(fun);
+	ctorTemplate.Reset(tpl);
+	Environment::atCleanup([]() {
+		constructor.Reset();
+		ctorTemplate.Reset();
+	});
+
+	// export the constructor: re2.js makes it the module's export
+	Nan::Set(exports, Nan::New("RE2").ToLocalChecked(), fun);
+}
+
+
+Local<Function> WrappedRE2Set::Initialize() {
+
+	// prepare constructor template
+	Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+	tpl->SetClassName(Nan::New("RE2Set").ToLocalChecked());
+	tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+	// prototype
+
+	Nan::SetPrototypeMethod(tpl, "match", Match);
+	Nan::SetPrototypeMethod(tpl, "test",  Test);
+
+	Local<ObjectTemplate> proto = tpl->PrototypeTemplate();
+	Nan::SetAccessor(proto, Nan::New("size").ToLocalChecked(),    GetSize);
+	Nan::SetAccessor(proto, Nan::New("flags").ToLocalChecked(),   GetFlags);
+	Nan::SetAccessor(proto, Nan::New("anchor").ToLocalChecked(),  GetAnchor);
+	Nan::SetAccessor(proto, Nan::New("sources").ToLocalChecked(), GetSources);
+
+	Local<Function> fun = Nan::GetFunction(tpl).ToLocalChecked();
+	constructor.Reset(fun);
+	ctorTemplate.Reset(tpl);
+	Environment::atCleanup([]() {
+		constructor.Reset();
+		ctorTemplate.Reset();
+	});
+
+	return fun;
+}
+
+
+Local<Function> WrappedRE2FilteredSet::Initialize() {
+
+	// prepare constructor template
+	Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+	tpl->SetClassName(Nan::New("RE2FilteredSet").ToLocalChecked());
+	tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+	// prototype
+
+	Nan::SetPrototypeMethod(tpl, "match", Match);
+	Nan::SetPrototypeMethod(tpl, "test",  Test);
+
+	Local<ObjectTemplate> proto = tpl->PrototypeTemplate();
+	Nan::SetAccessor(proto, Nan::New("size").ToLocalChecked(),          GetSize);
+	Nan::SetAccessor(proto, Nan::New("flags").ToLocalChecked(),         GetFlags);
+	Nan::SetAccessor(proto, Nan::New("sources").ToLocalChecked(),       GetSources);
+	Nan::SetAccessor(proto, Nan::New("atoms").ToLocalChecked(),         GetAtoms);
+	Nan::SetAccessor(proto, Nan::New("lastEvaluated").ToLocalChecked(), GetLastEvaluated);
+
+	Local<Function> fun = Nan::GetFunction(tpl).ToLocalChecked();
+	constructor.Reset(fun);
+	ctorTemplate.Reset(tpl);
+	Environment::atCleanup([]() {
+		constructor.Reset();
+		ctorTemplate.Reset();
+	});
+
+	return fun;
+}
+
+
+Local<Function> WrappedRE2MatchIterator::Initialize() {
+
+	// prepare constructor template
+	Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+	tpl->SetClassName(Nan::New("RE2MatchIterator").ToLocalChecked());
+	tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+	// prototype
+
+	Nan::SetPrototypeMethod(tpl, "next", Next);
+	tpl->PrototypeTemplate()->Set(v8::Symbol::GetIterator(Isolate::GetCurrent()), Nan::New<FunctionTemplate>(Self));
+
+	Local<Function> fun = Nan::GetFunction(tpl).ToLocalChecked();
+	constructor.Reset(fun);
+	ctorTemplate.Reset(tpl);
+	Environment::atCleanup([]() {
+		constructor.Reset();
+		ctorTemplate.Reset();
+	});
+
+	return fun;
+}
+
+
+Local<Function> WrappedRE2Scanner::Initialize() {
+
+	// prepare constructor template
+	Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+	tpl->SetClassName(Nan::New("RE2Scanner").ToLocalChecked());
+	tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+	// prototype
+
+	Nan::SetPrototypeMethod(tpl, "write", Write);
+	Nan::SetPrototypeMethod(tpl, "end",   End);
+
+	Local<ObjectTemplate> proto = tpl->PrototypeTemplate();
+	Nan::SetAccessor(proto, Nan::New("offset").ToLocalChecked(), GetOffset);
+
+	Local<Function> fun = Nan::GetFunction(tpl).ToLocalChecked();
 	constructor.Reset(fun);
 	ctorTemplate.Reset(tpl);
+	Environment::atCleanup([]() {
+		constructor.Reset();
+		ctorTemplate.Reset();
+	});
 
-	// return constructor as module's export
-	Nan::Set(module, Nan::New("exports").ToLocalChecked(), fun);
+	return fun;
 }
 
 
-void Initialize(Handle<Object> exports, Handle<Object> module) {
-	WrappedRE2::Initialize(exports, module);
+NAN_MODULE_INIT(Initialize) {
+	Environment::initialize();
+	Environment::atCleanup(releaseCachedHandles);
+	WrappedRE2::Initialize(target);
 }
 
 
-NODE_MODULE(re2, Initialize)
+NAN_MODULE_WORKER_ENABLED(re2, Initialize)
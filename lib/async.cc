@@ -0,0 +1,350 @@
+#include "./wrapped_re2.h"
+#include "./util.h"
+
+#include <memory>
+#include <vector>
+
+#include <node_buffer.h>
+
+
+using std::vector;
+
+using v8::Array;
+using v8::Local;
+using v8::Object;
+using v8::Value;
+
+
+// Asynchronous methods run RE2::Match() loops on the libuv thread pool.
+// Everything, which touches V8, happens on the main thread: converting a subject, translating lastIndex,
+// and forming a result. A worker keeps the RE2 object and the subject alive with persistent handles.
+// Strings are converted to UTF-8 copies (even external ones, which synchronous methods use in place),
+// while buffers are used in place, so they should not be modified until the operation is finished.
+
+
+class RE2Worker : public Nan::AsyncWorker {
+	protected:
+		RE2Worker(Nan::Callback* callback, WrappedRE2* re2, const Local<Object>& self, const Local<Value>& input) :
+				Nan::AsyncWorker(callback, "re2:async"), re2(re2), str(input, StrVal::COPY), matched(false) {
+			SaveToPersistent("re2",   self);
+			SaveToPersistent("input", input);
+			re2->hold();
+		}
+
+		~RE2Worker() { re2->release(); }
+
+		RE2::Anchor getAnchor() const { return re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED; }
+
+		void callBack(const Local<Value>& result) {
+			Nan::HandleScope scope;
+			Local<Value> argv[] = {Nan::Null(), result};
+			callback->Call(2, argv, async_resource);
+		}
+
+	public:
+		WrappedRE2* re2;
+		StrVal      str;
+		size_t      lastIndex;
+		bool        matched;
+};
+
+
+// exec()
+
+class ExecWorker : public RE2Worker {
+	public:
+		ExecWorker(Nan::Callback* callback, WrappedRE2* re2, const Local<Object>& self, const Local<Value>& input) :
+			RE2Worker(callback, re2, self, input), groups(re2->regexp->NumberOfCapturingGroups() + 1) {}
+
+		void Execute() {
+			matched = re2->match(str, lastIndex, str.size, getAnchor(), &groups[0], groups.size());
+		}
+
+		void HandleOKCallback() {
+			Nan::HandleScope scope;
+
+			if (!matched) {
+				if (re2->global || re2->sticky) {
+					re2->lastIndex = 0;
+				}
+				callBack(Nan::Null());
+				return;
+			}
+
+			Local<Array> result = formExecResult(re2, str, &groups[0], groups.size(), GetFromPersistent("input"));
+
+			if (re2->global || re2->sticky) {
+				re2->lastIndex = str.getUtf16Offset(groups[0].data() - str.data + groups[0].size());
+			}
+
+			callBack(result);
+		}
+
+	private:
+		vector<StringPiece> groups;
+};
+
+
+// test()
+
+class TestWorker : public RE2Worker {
+	public:
+		TestWorker(Nan::Callback* callback, WrappedRE2* re2, const Local<Object>& self, const Local<Value>& input) :
+			RE2Worker(callback, re2, self, input) {}
+
+		void Execute() {
+			if (re2->global || re2->sticky) {
+				matched = re2->match(str, lastIndex, str.size, getAnchor(), &match, 1);
+			} else {
+				matched = re2->match(str, 0, str.size, RE2::UNANCHORED, NULL, 0);
+			}
+		}
+
+		void HandleOKCallback() {
+			Nan::HandleScope scope;
+
+			if (re2->global || re2->sticky) {
+				re2->lastIndex = matched ? str.getUtf16Offset(match.data() - str.data + match.size()) : 0;
+			}
+
+			callBack(Nan::New(matched));
+		}
+
+	private:
+		StringPiece match;
+};
+
+
+// matchAll(): an array of exec()-like results, lastIndex is used as a starting point, but not updated
+
+class MatchAllWorker : public RE2Worker {
+	public:
+		MatchAllWorker(Nan::Callback* callback, WrappedRE2* re2, const Local<Object>& self, const Local<Value>& input) :
+			RE2Worker(callback, re2, self, input), stride(re2->regexp->NumberOfCapturingGroups() + 1) {}
+
+		void Execute() {
+			vector<StringPiece> match(stride);
+			RE2::Anchor anchor = getAnchor();
+			size_t index = lastIndex;
+			while (index <= str.size && re2->match(str, index, str.size, anchor, &match[0], stride)) {
+				groups.insert(groups.end(), match.begin(), match.end());
+				size_t end = match[0].data() - str.data + match[0].size();
+				index = match[0].size() ? end : end + (end < str.size ? getUtf8CharSize(str.data[end]) : 1);
+			}
+		}
+
+		void HandleOKCallback() {
+			Nan::HandleScope scope;
+
+			Local<Value> input = GetFromPersistent("input");
+			Local<Array> result = Nan::New<Array>();
+			for (size_t i = 0, n = groups.size() / stride; i < n; ++i) {
+				Nan::Set(result, i, formExecResult(re2, str, &groups[i * stride], stride, input));
+			}
+
+			callBack(result);
+		}
+
+	private:
+		size_t              stride;
+		vector<StringPiece> groups;
+};
+
+
+// replace() with a string replacer
+
+class ReplaceWorker : public RE2Worker {
+	public:
+		ReplaceWorker(Nan::Callback* callback, WrappedRE2* re2, const Local<Object>& self, const Local<Value>& input) :
+			RE2Worker(callback, re2, self, input), matchEnd(0) {}
+
+		void Execute() {
+			matched = replaceWithString(re2, str, lastIndex, *replacer, result, matchEnd);
+			if (result.failed) {
+				result.release();
+				SetErrorMessage("Out of memory: the result of replaceAsync() is too large.");
+			}
+		}
+
+		void HandleOKCallback() {
+			Nan::HandleScope scope;
+
+			if (re2->global) {
+				re2->lastIndex = 0;
+			} else if (re2->sticky) {
+				re2->lastIndex = matched ? str.getUtf16Offset(matchEnd) : 0;
+			}
+
+			callBack(result.toValue(str.isBuffer));
+		}
+
+		// a compiled template is immutable, so it can be shared with the main thread
+		std::shared_ptr<const ReplacementTemplate> replacer;
+
+	private:
+		OutputBuffer result;
+		size_t       matchEnd;
+};
+
+
+// common argument handling: returns a callback, or NULL, if an exception was thrown
+
+static Nan::Callback* getCallback(const Nan::FunctionCallbackInfo<Value>& info, int index) {
+	if (index >= info.Length() || !info[index]->IsFunction()) {
+		Nan::ThrowTypeError("A callback function was expected.");
+		return NULL;
+	}
+	return new Nan::Callback(info[index].As<Function>());
+}
+
+// translates lastIndex on the main thread, returns false, when the result is known without matching
+
+static bool prepare(RE2Worker* worker, bool useLastIndex) {
+	WrappedRE2* re2 = worker->re2;
+	worker->lastIndex = 0;
+	if (useLastIndex && re2->lastIndex) {
+		if (re2->lastIndex > worker->str.length) {
+			return false;
+		}
+		worker->lastIndex = worker->str.getUtf8Offset(re2->lastIndex);
+	}
+	return true;
+}
+
+
+NAN_METHOD(WrappedRE2::ExecAsync) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+
+	Nan::Callback* callback = getCallback(info, 1);
+	if (!callback) {
+		return;
+	}
+
+	ExecWorker* worker = new ExecWorker(callback, re2, info.This(), info[0]);
+	if (!worker->str.data) {
+		delete worker;
+		return;
+	}
+
+	// actual work
+
+	if (!prepare(worker, re2->global || re2->sticky)) {
+		// lastIndex is past the end: report no match without a round trip to the thread pool
+		worker->HandleOKCallback();
+		delete worker;
+		return;
+	}
+
+	Nan::AsyncQueueWorker(worker);
+}
+
+
+NAN_METHOD(WrappedRE2::TestAsync) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+
+	Nan::Callback* callback = getCallback(info, 1);
+	if (!callback) {
+		return;
+	}
+
+	TestWorker* worker = new TestWorker(callback, re2, info.This(), info[0]);
+	if (!worker->str.data) {
+		delete worker;
+		return;
+	}
+
+	// actual work
+
+	if (!prepare(worker, re2->global || re2->sticky)) {
+		worker->HandleOKCallback();
+		delete worker;
+		return;
+	}
+
+	Nan::AsyncQueueWorker(worker);
+}
+
+
+NAN_METHOD(WrappedRE2::MatchAllAsync) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+
+	Nan::Callback* callback = getCallback(info, 1);
+	if (!callback) {
+		return;
+	}
+
+	MatchAllWorker* worker = new MatchAllWorker(callback, re2, info.This(), info[0]);
+	if (!worker->str.data) {
+		delete worker;
+		return;
+	}
+
+	// actual work
+
+	if (!prepare(worker, re2->global || re2->sticky)) {
+		worker->HandleOKCallback();
+		delete worker;
+		return;
+	}
+
+	Nan::AsyncQueueWorker(worker);
+}
+
+
+NAN_METHOD(WrappedRE2::ReplaceAsync) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+
+	if (info[1]->IsFunction()) {
+		return Nan::ThrowTypeError("replaceAsync() supports only string or buffer replacements.");
+	}
+
+	Nan::Callback* callback = getCallback(info, 2);
+	if (!callback) {
+		return;
+	}
+
+	ReplaceWorker* worker = new ReplaceWorker(callback, re2, info.This(), info[0]);
+	if (!worker->str.data) {
+		delete worker;
+		return;
+	}
+
+	StrVal replacer(info[1]);
+	if (!replacer.data) {
+		delete worker;
+		return;
+	}
+	worker->replacer = re2->getReplacementTemplate(replacer.data, replacer.size);
+
+	// actual work
+
+	if (!prepare(worker, re2->sticky && !re2->global)) {
+		worker->lastIndex = worker->str.size;
+	}
+
+	Nan::AsyncQueueWorker(worker);
+}
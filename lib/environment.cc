@@ -0,0 +1,73 @@
+#include "./environment.h"
+
+#include <node.h>
+
+#include <algorithm>
+
+
+thread_local TrackedObjectWrap*               Environment::wrappers = NULL;
+thread_local std::vector<Environment::Cleanup> Environment::cleanups;
+thread_local bool                              Environment::registered = false;
+
+
+TrackedObjectWrap::TrackedObjectWrap() : prev(NULL), next(Environment::wrappers), holds(0) {
+	if (next) {
+		next->prev = this;
+	}
+	Environment::wrappers = this;
+}
+
+
+TrackedObjectWrap::~TrackedObjectWrap() {
+	if (prev) {
+		prev->next = next;
+	} else {
+		Environment::wrappers = next;
+	}
+	if (next) {
+		next->prev = prev;
+	}
+}
+
+
+void Environment::initialize() {
+	// the module can be initialized again in the same environment (e.g., after deleting it from require.cache),
+	// while node does not allow to add the same hook twice
+	if (registered) {
+		return;
+	}
+#if NODE_MAJOR_VERSION >= 10
+	node::AddEnvironmentCleanupHook(v8::Isolate::GetCurrent(), cleanup, NULL);
+#endif
+	registered = true;
+}
+
+
+void Environment::atCleanup(Cleanup cleanup) {
+	// functions are added on every initialization of the module, but called once
+	if (std::find(cleanups.begin(), cleanups.end(), cleanup) == cleanups.end()) {
+		cleanups.push_back(cleanup);
+	}
+}
+
+
+void Environment::cleanup(void*) {
+	// the hook is removed by node after the call
+	registered = false;
+
+	// delete native objects of live wrappers: destructors unlink them
+	for (TrackedObjectWrap* wrapper = wrappers; wrapper;) {
+		TrackedObjectWrap* next = wrapper->next;
+		if (!wrapper->holds) {
+			delete wrapper;
+		}
+		wrapper = next;
+	}
+
+	// release per-isolate handles
+	while (!cleanups.empty()) {
+		Cleanup cleanup = cleanups.back();
+		cleanups.pop_back();
+		cleanup();
+	}
+}
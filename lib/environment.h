@@ -0,0 +1,60 @@
+#ifndef ENVIRONMENT_H_
+#define ENVIRONMENT_H_
+
+
+#include <nan.h>
+
+#include <vector>
+
+
+// The addon is loaded separately by every environment: the main thread, and every worker thread.
+// Per-isolate state is kept in thread_local statics, and released by an environment cleanup hook.
+// V8 does not run finalizers of objects, which are still alive, when an isolate is disposed,
+// so wrappers are tracked in a list, and the hook deletes their native objects too. Otherwise
+// a terminated worker would leak them together with compiled programs shared with other threads.
+
+class TrackedObjectWrap : public Nan::ObjectWrap {
+
+	protected:
+		TrackedObjectWrap();
+
+	public:
+		virtual ~TrackedObjectWrap();
+
+		// asynchronous operations hold objects, which they use on the thread pool: the cleanup hook
+		// does not delete held objects, because an operation can outlive its environment
+		void hold()    { ++holds; }
+		void release() { --holds; }
+
+	private:
+		TrackedObjectWrap* prev;
+		TrackedObjectWrap* next;
+		unsigned           holds;
+
+		friend class Environment;
+};
+
+
+class Environment {
+
+	public:
+		typedef void (*Cleanup)();
+
+		// registers the cleanup hook of the current environment: called by the module initializer
+		static void initialize();
+
+		// adds a function, which releases per-isolate state: functions are called in reverse order
+		static void atCleanup(Cleanup cleanup);
+
+	private:
+		static void cleanup(void*);
+
+		static thread_local TrackedObjectWrap*    wrappers; // live wrappers of the current environment
+		static thread_local std::vector<Cleanup>  cleanups;
+		static thread_local bool                  registered; // the cleanup hook is added once per environment
+
+		friend class TrackedObjectWrap;
+};
+
+
+#endif
@@ -14,10 +14,87 @@ using std::vector;
 using v8::Array;
 using v8::Integer;
 using v8::Local;
+using v8::Object;
 using v8::String;
 using v8::Value;
 
 
+// named groups of results share one shape per regular expression with interned names
+
+void WrappedRE2::prepareResultShape() {
+	const map<int, string>& names = regexp->CapturingGroupNames();
+	if (names.empty()) {
+		return;
+	}
+
+	Local<v8::ObjectTemplate> tpl = Nan::New<v8::ObjectTemplate>();
+	Local<Array> keys = Nan::New<Array>(static_cast<int>(names.size()));
+	uint32_t i = 0;
+	for (pair<int, string> group: names) {
+		Local<String> key = internString(group.second.data(), group.second.size());
+		tpl->Set(key, Nan::Undefined());
+		Nan::Set(keys, i++, key);
+		groupIndices.push_back(group.first);
+	}
+
+	groupsTemplate.Reset(tpl);
+	groupNames.Reset(keys);
+}
+
+
+Local<Array> formExecResult(const WrappedRE2* re2, const StrVal& str, const StringPiece* groups, size_t size, const Local<Value>& input) {
+
+	v8::Isolate* isolate = v8::Isolate::GetCurrent();
+	Local<v8::Context> context = isolate->GetCurrentContext();
+
+	vector< Local<Value> > values(size);
+	Local<Array> result = Nan::New<Array>(static_cast<int>(size));
+
+	if (str.isBuffer) {
+		for (size_t i = 0; i < size; ++i) {
+			const StringPiece& item = groups[i];
+			if (item.data() != NULL) {
+				values[i] = Nan::CopyBuffer(item.data(), item.size()).ToLocalChecked();
+				Nan::Set(result, i, values[i]);
+			}
+		}
+	} else {
+		for (size_t i = 0; i < size; ++i) {
+			const StringPiece& item = groups[i];
+			if (item.data() != NULL) {
+				values[i] = Nan::New(item.data(), item.size()).ToLocalChecked();
+				Nan::Set(result, i, values[i]);
+			}
+		}
+	}
+
+	// properties are always added in the same order, so all results have the same hidden class
+	auto ignoreIndex(result->CreateDataProperty(context, getKey(KEY_INDEX), Nan::New<Integer>(
+		static_cast<int>(str.getUtf16Offset(groups[0].data() - str.data)))));
+
+	auto ignoreInput(result->CreateDataProperty(context, getKey(KEY_INPUT), input));
+
+	if (!re2->groupsTemplate.IsEmpty()) {
+		Local<Object> groupsObject = Nan::NewInstance(Nan::New(re2->groupsTemplate)).ToLocalChecked();
+		auto ignore(groupsObject->SetPrototype(context, Nan::Null()));
+
+		Local<Array> names = Nan::New(re2->groupNames);
+		for (size_t i = 0, n = re2->groupIndices.size(); i < n; ++i) {
+			size_t index = re2->groupIndices[i];
+			if (index < size && !values[index].IsEmpty()) {
+				auto ignoreGroup(groupsObject->CreateDataProperty(context, Nan::Get(names, i).ToLocalChecked().As<String>(), values[index]));
+			}
+		}
+
+		auto ignoreGroups(result->CreateDataProperty(context, getKey(KEY_GROUPS), groupsObject));
+	} else {
+		auto ignoreGroups(result->CreateDataProperty(context, getKey(KEY_GROUPS), Nan::Undefined()));
+	}
+
+	return result;
+}
+
+
 NAN_METHOD(WrappedRE2::Exec) {
 
 	// unpack arguments
@@ -35,33 +112,20 @@ NAN_METHOD(WrappedRE2::Exec) {
 
 	size_t lastIndex = 0;
 
-	if (str.isBuffer) {
-		if ((re2->global || re2->sticky) && re2->lastIndex) {
-			if (re2->lastIndex > str.size) {
-				re2->lastIndex = 0;
-				info.GetReturnValue().SetNull();
-				return;
-			}
-			lastIndex = re2->lastIndex;
-		}
-	} else {
-		if ((re2->global || re2-> sticky) && re2->lastIndex) {
-			if (re2->lastIndex > str.length) {
-				re2->lastIndex = 0;
-				info.GetReturnValue().SetNull();
-				return;
-			}
-			for (size_t n = re2->lastIndex; n; --n) {
-				lastIndex += getUtf8CharSize(str.data[lastIndex]);
-			}
+	if ((re2->global || re2->sticky) && re2->lastIndex) {
+		if (re2->lastIndex > str.length) {
+			re2->lastIndex = 0;
+			info.GetReturnValue().SetNull();
+			return;
 		}
+		lastIndex = str.getUtf8Offset(re2->lastIndex);
 	}
 
 	// actual work
 
-	vector<StringPiece> groups(re2->regexp.NumberOfCapturingGroups() + 1);
+	vector<StringPiece> groups(re2->regexp->NumberOfCapturingGroups() + 1);
 
-	if (!re2->regexp.Match(str, lastIndex, str.size, re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED, &groups[0], groups.size())) {
+	if (!re2->match(str, lastIndex, str.size, re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED, &groups[0], groups.size())) {
 		if (re2->global || re2->sticky) {
 			re2->lastIndex = 0;
 		}
@@ -71,52 +135,10 @@ NAN_METHOD(WrappedRE2::Exec) {
 
 	// form a result
 
-	Local<Array> result = Nan::New<Array>();
-
-	int indexOffset = re2->global || re2->sticky ? re2->lastIndex : 0;
-
-	if (str.isBuffer) {
-		for (size_t i = 0, n = groups.size(); i < n; ++i) {
-			const StringPiece& item = groups[i];
-			if (item.data() != NULL) {
-				Nan::Set(result, i, Nan::CopyBuffer(item.data(), item.size()).ToLocalChecked());
-			}
-		}
-		Nan::Set(result, Nan::New("index").ToLocalChecked(), Nan::New<Integer>(
-			indexOffset + static_cast<int>(groups[0].data() - str.data)));
-	} else {
-		for (size_t i = 0, n = groups.size(); i < n; ++i) {
-			const StringPiece& item = groups[i];
-			if (item.data() != NULL) {
-				Nan::Set(result, i, Nan::New(item.data(), item.size()).ToLocalChecked());
-			}
-		}
-		Nan::Set(result, Nan::New("index").ToLocalChecked(), Nan::New<Integer>(
-			indexOffset + static_cast<int>(getUtf16Length(str.data + lastIndex, groups[0].data()))));
-	}
-
-	Nan::Set(result, Nan::New("input").ToLocalChecked(), info[0]);
-
-	const map<int, string>& groupNames = re2->regexp.CapturingGroupNames();
-	if (!groupNames.empty()) {
-		Local<Object> groups = Nan::New<Object>();
-		auto ignore(groups->SetPrototype(v8::Isolate::GetCurrent()->GetCurrentContext(), Nan::Null()));
-
-		for (pair<int, string> group: groupNames) {
-			Nan::MaybeLocal<Value> value = Nan::Get(result, group.first);
-			if (!value.IsEmpty()) {
-				Nan::Set(groups, Nan::New(group.second).ToLocalChecked(), value.ToLocalChecked());
-			}
-		}
-
-		Nan::Set(result, Nan::New("groups").ToLocalChecked(), groups);
-	} else {
-		Nan::Set(result, Nan::New("groups").ToLocalChecked(), Nan::Undefined());
-	}
+	Local<Array> result = formExecResult(re2, str, &groups[0], groups.size(), info[0]);
 
 	if (re2->global || re2->sticky) {
-		re2->lastIndex += str.isBuffer ? groups[0].data() - str.data + groups[0].size() - lastIndex :
-			getUtf16Length(str.data + lastIndex, groups[0].data() + groups[0].size());
+		re2->lastIndex = str.getUtf16Offset(groups[0].data() - str.data + groups[0].size());
 	}
 
 	info.GetReturnValue().Set(result);
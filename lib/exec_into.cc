@@ -0,0 +1,87 @@
+#include "./wrapped_re2.h"
+#include "./util.h"
+
+#include <algorithm>
+#include <vector>
+
+
+using std::min;
+using std::vector;
+
+using v8::Int32Array;
+
+
+// execInto(str, int32Array): exec() without allocations, it writes [start, end) pairs of groups
+// into a caller-supplied array, and returns the number of written pairs, or -1, if nothing was matched.
+// A short array limits the number of reported groups, which makes matching cheaper too.
+
+NAN_METHOD(WrappedRE2::ExecInto) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		info.GetReturnValue().Set(-1);
+		return;
+	}
+
+	if (!info[1]->IsInt32Array()) {
+		return Nan::ThrowTypeError("An Int32Array was expected as the second argument.");
+	}
+
+	StrVal str(info[0], re2->scratch);
+	if (!str.data) {
+		return;
+	}
+
+	Nan::TypedArrayContents<int32_t> spans(info[1]);
+
+	size_t lastIndex = 0;
+
+	if ((re2->global || re2->sticky) && re2->lastIndex) {
+		if (re2->lastIndex > str.length) {
+			re2->lastIndex = 0;
+			info.GetReturnValue().Set(-1);
+			return;
+		}
+		lastIndex = str.getUtf8Offset(re2->lastIndex);
+	}
+
+	// actual work
+
+	size_t pairs = min(static_cast<size_t>(re2->regexp->NumberOfCapturingGroups() + 1), spans.length() / 2);
+
+	// the whole match is required to update lastIndex
+	vector<StringPiece>& groups = re2->groupsScratch;
+	size_t n = pairs || !(re2->global || re2->sticky) ? pairs : 1;
+	if (groups.size() < n) {
+		groups.resize(n);
+	}
+
+	if (!re2->match(str, lastIndex, str.size, re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED, n ? &groups[0] : NULL, n)) {
+		if (re2->global || re2->sticky) {
+			re2->lastIndex = 0;
+		}
+		info.GetReturnValue().Set(-1);
+		return;
+	}
+
+	// form a result
+
+	int32_t* data = *spans;
+	for (size_t i = 0; i < pairs; ++i) {
+		const StringPiece& item = groups[i];
+		if (item.data() == NULL) {
+			data[2 * i] = data[2 * i + 1] = -1;
+			continue;
+		}
+		data[2 * i]     = static_cast<int32_t>(str.getUtf16Offset(item.data() - str.data));
+		data[2 * i + 1] = static_cast<int32_t>(str.getUtf16Offset(item.data() - str.data + item.size()));
+	}
+
+	if (re2->global || re2->sticky) {
+		re2->lastIndex = str.getUtf16Offset(groups[0].data() - str.data + groups[0].size());
+	}
+
+	info.GetReturnValue().Set(static_cast<int>(pairs));
+}
@@ -0,0 +1,239 @@
+#include "./wrapped_re2.h"
+#include "./lazy_result.h"
+#include "./util.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+using std::map;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+using v8::Array;
+using v8::Integer;
+using v8::Local;
+using v8::Object;
+using v8::ObjectTemplate;
+using v8::String;
+using v8::Value;
+
+
+NAN_METHOD(WrappedRE2::ExecLazy) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		info.GetReturnValue().SetNull();
+		return;
+	}
+
+	unique_ptr<StrVal> str(new StrVal(info[0]));
+	if (!str->data) {
+		return;
+	}
+
+	size_t lastIndex = 0;
+
+	if ((re2->global || re2->sticky) && re2->lastIndex) {
+		if (re2->lastIndex > str->length) {
+			re2->lastIndex = 0;
+			info.GetReturnValue().SetNull();
+			return;
+		}
+		lastIndex = str->getUtf8Offset(re2->lastIndex);
+	}
+
+	// actual work
+
+	vector<StringPiece> groups(re2->regexp->NumberOfCapturingGroups() + 1);
+
+	if (!re2->match(*str, lastIndex, str->size, re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED, &groups[0], groups.size())) {
+		if (re2->global || re2->sticky) {
+			re2->lastIndex = 0;
+		}
+		info.GetReturnValue().SetNull();
+		return;
+	}
+
+	if (re2->global || re2->sticky) {
+		re2->lastIndex = str->getUtf16Offset(groups[0].data() - str->data + groups[0].size());
+	}
+
+	// form a result
+
+	Nan::MaybeLocal<Object> result = LazyResult::Create(re2, info.This(), str, groups, info[0]);
+	if (!result.IsEmpty()) {
+		info.GetReturnValue().Set(result.ToLocalChecked());
+	}
+}
+
+
+void LazyResult::Initialize() {
+	Local<ObjectTemplate> tpl = Nan::New<ObjectTemplate>();
+	tpl->SetInternalFieldCount(1);
+	Nan::SetIndexedPropertyHandler(tpl, GetIndex, 0, QueryIndex, 0, EnumerateIndices);
+	Nan::SetAccessor(tpl, getKey(KEY_GROUPS), GetGroups);
+	resultTemplate.Reset(tpl);
+
+	// the groups object refers to its result, so the result is alive as long as its groups are
+	Local<ObjectTemplate> groupsTpl = Nan::New<ObjectTemplate>();
+	groupsTpl->SetInternalFieldCount(2);
+	Nan::SetNamedPropertyHandler(groupsTpl, GetGroup, 0, QueryGroup, 0, EnumerateGroups);
+	groupsTemplate.Reset(groupsTpl);
+
+	arrayPrototype.Reset(Nan::New<Array>()->GetPrototype());
+
+	Environment::atCleanup([]() {
+		resultTemplate.Reset();
+		groupsTemplate.Reset();
+		arrayPrototype.Reset();
+	});
+}
+
+
+Nan::MaybeLocal<Object> LazyResult::Create(WrappedRE2* re2, const Local<Object>& regexp, unique_ptr<StrVal>& str,
+		const vector<StringPiece>& groups, const Local<Value>& input) {
+
+	Nan::MaybeLocal<Object> maybeResult = Nan::NewInstance(Nan::New(resultTemplate));
+	if (maybeResult.IsEmpty()) {
+		return maybeResult;
+	}
+
+	Local<Object> result = maybeResult.ToLocalChecked();
+	auto ignore(result->SetPrototype(v8::Isolate::GetCurrent()->GetCurrentContext(), Nan::New(arrayPrototype)));
+
+	LazyResult* self = new LazyResult();
+	self->Wrap(result);
+	self->re2 = re2;
+	self->regexp.Reset(regexp);
+	self->input.Reset(input);
+	self->values.Reset(Nan::New<Array>());
+	self->groups = groups;
+	self->str.swap(str);
+
+	const StrVal& subject = *self->str;
+	Nan::Set(result, Nan::New("length").ToLocalChecked(), Nan::New(static_cast<int>(groups.size())));
+	Nan::Set(result, getKey(KEY_INDEX), Nan::New<Integer>(
+		static_cast<int>(subject.getUtf16Offset(groups[0].data() - subject.data))));
+	Nan::Set(result, getKey(KEY_INPUT), input);
+
+	return result;
+}
+
+
+Local<Value> LazyResult::materialize(size_t index) {
+	Local<Array> cache = Nan::New(values);
+	if (Nan::Has(cache, index).FromMaybe(false)) {
+		return Nan::Get(cache, index).ToLocalChecked();
+	}
+
+	const StringPiece& item = groups[index];
+	Local<Value> value;
+	if (str->isBuffer) {
+		value = Nan::CopyBuffer(item.data(), item.size()).ToLocalChecked();
+	} else {
+		value = Nan::New(item.data(), item.size()).ToLocalChecked();
+	}
+
+	// values are cached, so repeated reads return the same object
+	Nan::Set(cache, index, value);
+	return value;
+}
+
+
+NAN_INDEX_GETTER(LazyResult::GetIndex) {
+	LazyResult* self = Nan::ObjectWrap::Unwrap<LazyResult>(info.Holder());
+	if (self && self->isMatched(index)) {
+		info.GetReturnValue().Set(self->materialize(index));
+	}
+}
+
+
+NAN_INDEX_QUERY(LazyResult::QueryIndex) {
+	LazyResult* self = Nan::ObjectWrap::Unwrap<LazyResult>(info.Holder());
+	if (self && self->isMatched(index)) {
+		info.GetReturnValue().Set(Nan::New<Integer>(v8::ReadOnly | v8::DontDelete));
+	}
+}
+
+
+NAN_INDEX_ENUMERATOR(LazyResult::EnumerateIndices) {
+	LazyResult* self = Nan::ObjectWrap::Unwrap<LazyResult>(info.Holder());
+	Local<Array> indices = Nan::New<Array>();
+	if (self) {
+		for (size_t i = 0, j = 0, n = self->groups.size(); i < n; ++i) {
+			if (self->isMatched(i)) {
+				Nan::Set(indices, j++, Nan::New(static_cast<int>(i)));
+			}
+		}
+	}
+	info.GetReturnValue().Set(indices);
+}
+
+
+NAN_GETTER(LazyResult::GetGroups) {
+	LazyResult* self = Nan::ObjectWrap::Unwrap<LazyResult>(info.Holder());
+	if (!self || self->re2->regexp->NamedCapturingGroups().empty()) {
+		info.GetReturnValue().Set(Nan::Undefined());
+		return;
+	}
+
+	Nan::MaybeLocal<Object> maybeGroups = Nan::NewInstance(Nan::New(groupsTemplate));
+	if (maybeGroups.IsEmpty()) {
+		return;
+	}
+
+	Local<Object> groups = maybeGroups.ToLocalChecked();
+	auto ignore(groups->SetPrototype(v8::Isolate::GetCurrent()->GetCurrentContext(), Nan::Null()));
+	Nan::SetInternalFieldPointer(groups, 0, self);
+	groups->SetInternalField(1, info.Holder());
+
+	// the groups object is created once
+	Nan::DefineOwnProperty(info.Holder(), property, groups, v8::ReadOnly);
+	info.GetReturnValue().Set(groups);
+}
+
+
+static LazyResult* getResult(const Local<Object>& groups) {
+	return static_cast<LazyResult*>(Nan::GetInternalFieldPointer(groups, 0));
+}
+
+
+NAN_PROPERTY_GETTER(LazyResult::GetGroup) {
+	LazyResult* self = getResult(info.Holder());
+	const map<string, int>& names = self->re2->regexp->NamedCapturingGroups();
+	map<string, int>::const_iterator group = names.find(*Nan::Utf8String(property));
+	if (group == names.end()) {
+		return;
+	}
+	if (self->isMatched(group->second)) {
+		info.GetReturnValue().Set(self->materialize(group->second));
+		return;
+	}
+	info.GetReturnValue().Set(Nan::Undefined());
+}
+
+
+NAN_PROPERTY_QUERY(LazyResult::QueryGroup) {
+	LazyResult* self = getResult(info.Holder());
+	const map<string, int>& names = self->re2->regexp->NamedCapturingGroups();
+	if (names.find(*Nan::Utf8String(property)) != names.end()) {
+		info.GetReturnValue().Set(Nan::New<Integer>(v8::ReadOnly | v8::DontDelete));
+	}
+}
+
+
+NAN_PROPERTY_ENUMERATOR(LazyResult::EnumerateGroups) {
+	LazyResult* self = getResult(info.Holder());
+	Local<Array> names = Nan::New<Array>();
+	uint32_t i = 0;
+	for (const auto& group: self->re2->regexp->NamedCapturingGroups()) {
+		Nan::Set(names, i++, Nan::New(group.first).ToLocalChecked());
+	}
+	info.GetReturnValue().Set(names);
+}
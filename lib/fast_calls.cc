@@ -0,0 +1,240 @@
+#include "./wrapped_re2.h"
+#include "./util.h"
+
+
+// V8 fast API calls are declared in v8-fast-api-calls.h, which is not shipped with headers of node 20 and 22.
+// Their node binaries export the V8 functions used below anyway, so on those V8 versions the few types are declared
+// here: their layouts should match v8-fast-api-calls.h of V8 11.3 (node 20), and V8 12.4 (node 22).
+// Other versions without the header register regular versions of methods only.
+
+#if V8_MAJOR_VERSION >= 11 && defined(__has_include)
+#if __has_include(<v8-fast-api-calls.h>)
+#define RE2_FAST_API_CALLS
+#include <v8-fast-api-calls.h>
+#endif
+#endif
+
+#if !defined(RE2_FAST_API_CALLS) && ((V8_MAJOR_VERSION == 11 && V8_MINOR_VERSION == 3) || (V8_MAJOR_VERSION == 12 && V8_MINOR_VERSION == 4))
+#define RE2_FAST_API_CALLS
+
+namespace v8 {
+
+class CTypeInfo {
+	public:
+		enum class Type : uint8_t {kVoid, kBool, kUint8, kInt32, kUint32, kInt64, kUint64, kFloat32, kFloat64, kPointer, kV8Value, kSeqOneByteString};
+		enum class SequenceType : uint8_t {kScalar};
+		enum class Flags : uint8_t {kNone = 0};
+
+		explicit constexpr CTypeInfo(Type type, SequenceType sequence_type = SequenceType::kScalar, Flags flags = Flags::kNone) :
+			type_(type), sequence_type_(sequence_type), flags_(flags) {}
+
+		Type         type_;
+		SequenceType sequence_type_;
+		Flags        flags_;
+};
+
+struct FastOneByteString {
+	const char* data;
+	uint32_t    length;
+};
+
+class V8_EXPORT CFunctionInfo {
+	public:
+#if V8_MAJOR_VERSION >= 12
+		enum class Int64Representation : uint8_t {kNumber = 0, kBigInt = 1};
+
+		CFunctionInfo(const CTypeInfo& return_info, unsigned int arg_count, const CTypeInfo* arg_info,
+			Int64Representation repr = Int64Representation::kNumber);
+#else
+		CFunctionInfo(const CTypeInfo& return_info, unsigned int arg_count, const CTypeInfo* arg_info);
+#endif
+
+		const CTypeInfo return_info_;
+#if V8_MAJOR_VERSION >= 12
+		const Int64Representation repr_;
+#endif
+		const unsigned int arg_count_;
+		const CTypeInfo*   arg_info_;
+};
+
+class V8_EXPORT CFunction {
+	public:
+		CFunction(const void* address, const CFunctionInfo* type_info);
+
+		const void*          address_;
+		const CFunctionInfo* type_info_;
+};
+
+}
+
+#endif
+
+
+using v8::FunctionTemplate;
+using v8::Local;
+using v8::Object;
+using v8::Value;
+
+
+#ifdef RE2_FAST_API_CALLS
+
+// V8 fast API calls: when test() or search() is called from optimized code with a flat one-byte string,
+// V8 calls a plain C++ function with the string's characters instead of going through FunctionCallbackInfo.
+// Other arguments (two-byte strings, buffers, non-strings) take the regular path.
+// A fast call cannot allocate on the V8 heap, or throw, so both functions reproduce their regular versions
+// without V8 calls. ASCII strings are matched in place, other one-byte (Latin-1) strings are converted to UTF-8
+// into a scratch buffer of an RE2 object.
+
+class OneByteText {
+	public:
+		OneByteText(WrappedRE2* re2, const v8::FastOneByteString& str) :
+				length(str.length), chars(reinterpret_cast<const unsigned char*>(str.data)) {
+			const char* end = str.data + length;
+			const char* nonAscii = findNonAscii(str.data, end);
+			ascii = nonAscii == end;
+			if (ascii) {
+				text = StringPiece(str.data, length);
+				return;
+			}
+			std::vector<char>& buffer = re2->scratch;
+			buffer.assign(str.data, nonAscii);
+			for (const unsigned char* p = reinterpret_cast<const unsigned char*>(nonAscii); p != chars + length; ++p) {
+				if (*p < 0x80) {
+					buffer.push_back(*p);
+				} else {
+					buffer.push_back(static_cast<char>(0xC0 | (*p >> 6)));
+					buffer.push_back(static_cast<char>(0x80 | (*p & 0x3F)));
+				}
+			}
+			text = StringPiece(buffer.empty() ? "" : &buffer[0], buffer.size());
+		}
+
+		size_t getUtf8Offset(size_t index) const {
+			if (ascii) {
+				return index;
+			}
+			size_t offset = index;
+			for (size_t i = 0; i < index; ++i) {
+				offset += chars[i] >> 7;
+			}
+			return offset;
+		}
+
+		size_t getUtf16Offset(size_t offset) const {
+			if (ascii) {
+				return offset;
+			}
+			size_t index = 0;
+			for (size_t bytes = 0; bytes < offset; ++index) {
+				bytes += 1 + (chars[index] >> 7);
+			}
+			return index;
+		}
+
+		StringPiece text;
+		size_t      length;
+
+	private:
+		const unsigned char* chars;
+		bool                 ascii;
+};
+
+
+static WrappedRE2* unwrap(const Local<Object>& receiver) {
+	// other wrappers (sets, iterators, scanners) have internal fields too; a check does not allocate on the V8 heap,
+	// but it needs a handle of the template
+	Nan::HandleScope scope;
+	if (!WrappedRE2::HasInstance(receiver)) {
+		return NULL;
+	}
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(receiver);
+	if (WrappedRE2::collectStats.load(std::memory_order_relaxed)) {
+		re2->stats.fastCalls.fetch_add(1, std::memory_order_relaxed);
+		WrappedRE2::totals.fastCalls.fetch_add(1, std::memory_order_relaxed);
+	}
+	return re2;
+}
+
+static bool FastTest(Local<Object> receiver, const v8::FastOneByteString& str) {
+	WrappedRE2* re2 = unwrap(receiver);
+	if (!re2) {
+		return false;
+	}
+
+	OneByteText a(re2, str);
+	if (!re2->global && !re2->sticky) {
+		return re2->match(a.text, 0, a.text.size(), RE2::UNANCHORED, NULL, 0);
+	}
+
+	if (re2->lastIndex > a.length) {
+		re2->lastIndex = 0;
+		return false;
+	}
+	StringPiece match;
+	if (re2->match(a.text, a.getUtf8Offset(re2->lastIndex), a.text.size(), re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED, &match, 1)) {
+		re2->lastIndex = a.getUtf16Offset(match.data() - a.text.data() + match.size());
+		return true;
+	}
+	re2->lastIndex = 0;
+	return false;
+}
+
+static int32_t FastSearch(Local<Object> receiver, const v8::FastOneByteString& str) {
+	WrappedRE2* re2 = unwrap(receiver);
+	if (!re2) {
+		return -1;
+	}
+
+	OneByteText a(re2, str);
+	StringPiece match;
+	if (re2->match(a.text, 0, a.text.size(), re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED, &match, 1)) {
+		return static_cast<int32_t>(a.getUtf16Offset(match.data() - a.text.data()));
+	}
+	return -1;
+}
+
+
+static void setFastMethod(Local<FunctionTemplate> tpl, const char* name, v8::FunctionCallback slow, const v8::CFunction* fast) {
+	v8::Isolate* isolate = v8::Isolate::GetCurrent();
+	Local<FunctionTemplate> method = FunctionTemplate::New(isolate, slow, Local<Value>(), v8::Signature::New(isolate, tpl), 0,
+		v8::ConstructorBehavior::kThrow, v8::SideEffectType::kHasSideEffect, fast);
+	Local<v8::String> methodName = Nan::New(name).ToLocalChecked();
+	method->SetClassName(methodName);
+	tpl->PrototypeTemplate()->Set(methodName, method);
+}
+
+const bool WrappedRE2::hasFastCalls = true;
+
+#else
+
+const bool WrappedRE2::hasFastCalls = false;
+
+#endif
+
+
+void WrappedRE2::SetTestAndSearch(Local<FunctionTemplate> tpl) {
+#ifdef RE2_FAST_API_CALLS
+	// regular versions are called by V8 directly, not through NAN
+	v8::FunctionCallback slowTest = [](const v8::FunctionCallbackInfo<Value>& info) {
+		Test(Nan::FunctionCallbackInfo<Value>(info, Local<Value>()));
+	};
+	v8::FunctionCallback slowSearch = [](const v8::FunctionCallbackInfo<Value>& info) {
+		Search(Nan::FunctionCallbackInfo<Value>(info, Local<Value>()));
+	};
+
+	// signatures are described by hand, because CFunction::Make() is not available without v8-fast-api-calls.h:
+	// (receiver, string) -> bool for test(), and -> int32 for search()
+	typedef v8::CTypeInfo::Type Type;
+	static const v8::CTypeInfo     args[] = {v8::CTypeInfo(Type::kV8Value), v8::CTypeInfo(Type::kSeqOneByteString)};
+	static const v8::CFunctionInfo testInfo(v8::CTypeInfo(Type::kBool), 2, args);
+	static const v8::CFunctionInfo searchInfo(v8::CTypeInfo(Type::kInt32), 2, args);
+	static const v8::CFunction     fastTest(reinterpret_cast<const void*>(FastTest), &testInfo);
+	static const v8::CFunction     fastSearch(reinterpret_cast<const void*>(FastSearch), &searchInfo);
+
+	setFastMethod(tpl, "test",   slowTest,   &fastTest);
+	setFastMethod(tpl, "search", slowSearch, &fastSearch);
+#else
+	Nan::SetPrototypeMethod(tpl, "test",   Test);
+	Nan::SetPrototypeMethod(tpl, "search", Search);
+#endif
+}
@@ -0,0 +1,302 @@
+#include "./wrapped_re2_filtered_set.h"
+#include "./util.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+using std::max;
+using std::sort;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+using v8::Array;
+using v8::Local;
+using v8::Value;
+
+
+// memory budget of the atom matcher per atom: its DFA grows with the number of literals
+static const int64_t ATOM_MEMORY = 4096;
+
+
+void WrappedRE2FilteredSet::getPotentials(const StringPiece& text, vector<int>& potentials) const {
+	vector<int> matchedAtoms;
+	if (atomMatcher) {
+		RE2::Set::ErrorInfo error;
+		if (!atomMatcher->Match(text, &matchedAtoms, &error) && error.kind != RE2::Set::kNoError) {
+			// atoms are unknown (e.g., the DFA is out of memory): every rule should be evaluated
+			potentials.resize(sources.size());
+			for (size_t i = 0, n = potentials.size(); i < n; ++i) {
+				potentials[i] = i;
+			}
+			return;
+		}
+		sort(matchedAtoms.begin(), matchedAtoms.end());
+	}
+	filter.AllPotentials(matchedAtoms, &potentials);
+}
+
+
+NAN_METHOD(WrappedRE2FilteredSet::New) {
+
+	if (!info.IsConstructCall()) {
+		// call a constructor and return the result
+
+		vector< Local<Value> > parameters(info.Length());
+		for (size_t i = 0, n = info.Length(); i < n; ++i) {
+			parameters[i] = info[i];
+		}
+		auto newObject = Nan::NewInstance(Nan::New<Function>(constructor), parameters.size(), &parameters[0]);
+		if (!newObject.IsEmpty()) {
+			info.GetReturnValue().Set(newObject.ToLocalChecked());
+		}
+		return;
+	}
+
+	// process arguments
+
+	if (!info[0]->IsArray()) {
+		return Nan::ThrowTypeError("Expected an array of patterns as the 1st argument.");
+	}
+
+	bool ignoreCase = false;
+	bool multiline = false;
+	int  minAtomLength = 3;
+
+	int optionsArg = 1;
+	if (info.Length() > 1 && parseFlags(info[1], ignoreCase, multiline)) {
+		optionsArg = 2;
+	}
+	if (info.Length() > optionsArg && info[optionsArg]->IsObject()) {
+		Local<Value> value(Nan::Get(info[optionsArg].As<Object>(), Nan::New("minAtomLength").ToLocalChecked()).ToLocalChecked());
+		if (value->IsNumber()) {
+			minAtomLength = value.As<v8::Number>()->Value();
+			if (minAtomLength < 0) {
+				minAtomLength = 0;
+			}
+		}
+	}
+
+	// create and fill a filter
+
+	RE2::Options options;
+	options.set_case_sensitive(!ignoreCase);
+	options.set_one_line(!multiline);
+	options.set_log_errors(false); // inappropriate when embedding
+
+	unique_ptr<WrappedRE2FilteredSet> re2set(new WrappedRE2FilteredSet(minAtomLength, ignoreCase, multiline));
+
+	Local<Array> patterns(info[0].As<Array>());
+	vector<char> buffer;
+	string source;
+	StringPiece pattern;
+	int id;
+
+	for (uint32_t i = 0, n = patterns->Length(); i < n; ++i) {
+		Nan::MaybeLocal<Value> item(Nan::Get(patterns, i));
+		if (item.IsEmpty()) {
+			return;
+		}
+		if (!getPattern(item.ToLocalChecked(), buffer, source, pattern)) {
+			return Nan::ThrowTypeError("Expected string, Buffer, RegExp, or RE2 as a pattern.");
+		}
+		if (re2set->filter.Add(pattern, options, &id) != RE2::NoError) {
+			// FilteredRE2 reports only an error code, so compile the pattern again for a message
+			RE2 regexp(pattern, options);
+			return Nan::ThrowSyntaxError(regexp.error().c_str());
+		}
+		re2set->sources.push_back(source);
+	}
+
+	if (!re2set->sources.empty()) {
+		re2set->filter.Compile(&re2set->atoms);
+	}
+
+	// atoms are matched with a set of literals: it scans a text once for all of them
+
+	if (!re2set->atoms.empty()) {
+		RE2::Options atomOptions;
+		atomOptions.set_case_sensitive(false); // atoms are lower-cased
+		atomOptions.set_log_errors(false);
+		atomOptions.set_max_mem(max(static_cast<int64_t>(atomOptions.max_mem()), static_cast<int64_t>(re2set->atoms.size()) * ATOM_MEMORY));
+
+		re2set->atomMatcher.reset(new RE2::Set(atomOptions, RE2::UNANCHORED));
+		string error;
+		for (size_t i = 0, n = re2set->atoms.size(); i < n; ++i) {
+			if (re2set->atomMatcher->Add(RE2::QuoteMeta(re2set->atoms[i]), &error) < 0) {
+				return Nan::ThrowError(error.c_str());
+			}
+		}
+		if (!re2set->atomMatcher->Compile()) {
+			return Nan::ThrowError("RE2.FilteredSet could not be compiled.");
+		}
+	}
+
+	re2set->Wrap(info.This());
+	re2set.release();
+
+	info.GetReturnValue().Set(info.This());
+}
+
+
+NAN_METHOD(WrappedRE2FilteredSet::Match) {
+
+	Local<Array> result = Nan::New<Array>();
+
+	// unpack arguments
+
+	WrappedRE2FilteredSet* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2FilteredSet>(info.This());
+	if (!re2set) {
+		info.GetReturnValue().Set(result);
+		return;
+	}
+
+	vector<int> matches;
+	{
+		// a subject can be borrowed from the V8 heap, so it is released before V8 is called
+		StrVal str(info[0], StrVal::BORROW_FLAT);
+		if (!str.data) {
+			return;
+		}
+
+		// actual work
+
+		vector<int> potentials;
+		if (!re2set->sources.empty()) {
+			re2set->getPotentials(str, potentials);
+			sort(potentials.begin(), potentials.end());
+		}
+		re2set->lastEvaluated = potentials.size();
+
+		for (size_t i = 0, n = potentials.size(); i < n; ++i) {
+			int id = potentials[i];
+			if (re2set->filter.GetRE2(id).Match(str, 0, str.size, RE2::UNANCHORED, NULL, 0)) {
+				matches.push_back(id);
+			}
+		}
+	}
+
+	// form a result
+
+	for (size_t i = 0, n = matches.size(); i < n; ++i) {
+		Nan::Set(result, i, Nan::New(matches[i]));
+	}
+
+	info.GetReturnValue().Set(result);
+}
+
+
+NAN_METHOD(WrappedRE2FilteredSet::Test) {
+
+	// unpack arguments
+
+	WrappedRE2FilteredSet* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2FilteredSet>(info.This());
+	if (!re2set) {
+		info.GetReturnValue().Set(false);
+		return;
+	}
+
+	// only booleans are returned below, so a subject can be borrowed from the V8 heap
+	StrVal str(info[0], StrVal::BORROW_FLAT);
+	if (!str.data) {
+		return;
+	}
+
+	// actual work
+
+	vector<int> potentials;
+	if (!re2set->sources.empty()) {
+		re2set->getPotentials(str, potentials);
+	}
+
+	for (size_t i = 0, n = potentials.size(); i < n; ++i) {
+		if (re2set->filter.GetRE2(potentials[i]).Match(str, 0, str.size, RE2::UNANCHORED, NULL, 0)) {
+			re2set->lastEvaluated = i + 1;
+			info.GetReturnValue().Set(true);
+			return;
+		}
+	}
+
+	re2set->lastEvaluated = potentials.size();
+	info.GetReturnValue().Set(false);
+}
+
+
+NAN_GETTER(WrappedRE2FilteredSet::GetSize) {
+	if (!WrappedRE2FilteredSet::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2FilteredSet* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2FilteredSet>(info.This());
+	info.GetReturnValue().Set(static_cast<int>(re2set->sources.size()));
+}
+
+
+NAN_GETTER(WrappedRE2FilteredSet::GetFlags) {
+	if (!WrappedRE2FilteredSet::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2FilteredSet* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2FilteredSet>(info.This());
+
+	string flags;
+	if (re2set->ignoreCase) {
+		flags = "i";
+	}
+	if (re2set->multiline) {
+		flags += "m";
+	}
+	flags += "u";
+
+	info.GetReturnValue().Set(Nan::New(flags).ToLocalChecked());
+}
+
+
+NAN_GETTER(WrappedRE2FilteredSet::GetSources) {
+	if (!WrappedRE2FilteredSet::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2FilteredSet* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2FilteredSet>(info.This());
+
+	Local<Array> result = Nan::New<Array>();
+	for (size_t i = 0, n = re2set->sources.size(); i < n; ++i) {
+		Nan::Set(result, i, Nan::New(re2set->sources[i]).ToLocalChecked());
+	}
+
+	info.GetReturnValue().Set(result);
+}
+
+
+NAN_GETTER(WrappedRE2FilteredSet::GetAtoms) {
+	if (!WrappedRE2FilteredSet::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2FilteredSet* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2FilteredSet>(info.This());
+
+	Local<Array> result = Nan::New<Array>();
+	for (size_t i = 0, n = re2set->atoms.size(); i < n; ++i) {
+		Nan::Set(result, i, Nan::New(re2set->atoms[i]).ToLocalChecked());
+	}
+
+	info.GetReturnValue().Set(result);
+}
+
+
+NAN_GETTER(WrappedRE2FilteredSet::GetLastEvaluated) {
+	if (!WrappedRE2FilteredSet::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2FilteredSet* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2FilteredSet>(info.This());
+	info.GetReturnValue().Set(static_cast<int>(re2set->lastEvaluated));
+}
@@ -0,0 +1,59 @@
+#ifndef LAZY_RESULT_H_
+#define LAZY_RESULT_H_
+
+
+#include "./wrapped_re2.h"
+#include "./util.h"
+
+#include <memory>
+#include <vector>
+
+
+// an exec()-like result returned by execLazy(): it keeps match spans,
+// and creates strings (or buffers) for groups only when they are read
+
+class LazyResult : public TrackedObjectWrap {
+
+	private:
+		LazyResult() : re2(NULL) {}
+
+		static NAN_INDEX_GETTER(GetIndex);
+		static NAN_INDEX_QUERY(QueryIndex);
+		static NAN_INDEX_ENUMERATOR(EnumerateIndices);
+
+		static NAN_GETTER(GetGroups);
+
+		static NAN_PROPERTY_GETTER(GetGroup);
+		static NAN_PROPERTY_QUERY(QueryGroup);
+		static NAN_PROPERTY_ENUMERATOR(EnumerateGroups);
+
+		static thread_local Nan::Persistent<v8::ObjectTemplate>	resultTemplate;
+		static thread_local Nan::Persistent<v8::ObjectTemplate>	groupsTemplate;
+		static thread_local Nan::Persistent<v8::Value>			arrayPrototype;
+
+		bool isMatched(size_t index) const { return index < groups.size() && groups[index].data() != NULL; }
+		Local<v8::Value> materialize(size_t index);
+
+	public:
+		~LazyResult() {
+			regexp.Reset();
+			input.Reset();
+			values.Reset();
+		}
+
+		static void Initialize();
+
+		// takes the ownership of a subject, groups point into it
+		static Nan::MaybeLocal<Object> Create(WrappedRE2* re2, const Local<Object>& regexp, std::unique_ptr<StrVal>& str,
+			const std::vector<StringPiece>& groups, const Local<v8::Value>& input);
+
+		WrappedRE2*                 re2;
+		Nan::Persistent<Object>     regexp;
+		Nan::Persistent<v8::Value>  input;
+		Nan::Persistent<v8::Array>  values;
+		std::unique_ptr<StrVal>     str;
+		std::vector<StringPiece>    groups;
+};
+
+
+#endif
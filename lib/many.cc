@@ -0,0 +1,240 @@
+#include "./wrapped_re2.h"
+#include "./util.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <node_buffer.h>
+
+
+using std::fill;
+using std::unique_ptr;
+using std::vector;
+
+using v8::Array;
+using v8::ArrayBuffer;
+using v8::Int32Array;
+using v8::Isolate;
+using v8::Local;
+using v8::MaybeLocal;
+using v8::String;
+using v8::Uint8Array;
+using v8::Value;
+
+
+// Subjects of batch methods: an array of strings and buffers, or a buffer with an Int32Array of n + 1 boundaries.
+// Strings are converted one by one into a reusable buffer, buffers are used in place.
+
+class Subjects {
+	public:
+		Subjects(const Local<Value>& arg, const Local<Value>& bounds) : count(0), valid(false), base(NULL), offsets(NULL), isBuffer(false), isAscii(false) {
+			if (node::Buffer::HasInstance(arg)) {
+				if (!bounds->IsInt32Array()) {
+					Nan::ThrowTypeError("An Int32Array of offsets was expected after a buffer.");
+					return;
+				}
+				boundaries.reset(new Nan::TypedArrayContents<int32_t>(bounds));
+				offsets = **boundaries;
+				size_t n = boundaries->length(), size = node::Buffer::Length(arg);
+				for (size_t i = 0; i < n; ++i) {
+					if (offsets[i] < 0 || static_cast<size_t>(offsets[i]) > size || (i && offsets[i] < offsets[i - 1])) {
+						Nan::ThrowRangeError("Offsets should be non-decreasing, and within a buffer.");
+						return;
+					}
+				}
+				base  = node::Buffer::Data(arg);
+				count = n ? n - 1 : 0;
+				valid = true;
+				return;
+			}
+			if (!arg->IsArray()) {
+				Nan::ThrowTypeError("An array, or a buffer with offsets, was expected.");
+				return;
+			}
+			array = arg.As<Array>();
+			count = array->Length();
+			valid = true;
+		}
+
+		// returns false, if an exception was thrown
+		bool get(size_t i, StringPiece& subject) {
+			if (base) {
+				isBuffer = true;
+				subject = StringPiece(base + offsets[i], offsets[i + 1] - offsets[i]);
+				return true;
+			}
+			MaybeLocal<Value> item(Nan::Get(array, i));
+			if (item.IsEmpty()) {
+				return false;
+			}
+			Local<Value> value(item.ToLocalChecked());
+			if (node::Buffer::HasInstance(value)) {
+				isBuffer = true;
+				subject = StringPiece(node::Buffer::Data(value), node::Buffer::Length(value));
+				return true;
+			}
+			MaybeLocal<String> t(value->ToString(Isolate::GetCurrent()->GetCurrentContext()));
+			if (t.IsEmpty()) {
+				return false;
+			}
+			Local<String> s(t.ToLocalChecked());
+			size_t length = s->Length();
+			// a UTF-16 code unit takes at most 3 bytes, so we can skip measuring a string
+			if (buffer.size() < length * 3 + 1) {
+				buffer.resize(length * 3 + 1);
+			}
+			size_t size = writeUtf8Chars(s, &buffer[0], static_cast<int>(buffer.size()), String::NO_NULL_TERMINATION);
+			isBuffer = false;
+			isAscii  = size == length;
+			subject  = StringPiece(&buffer[0], size);
+			return true;
+		}
+
+		// offsets are reported in bytes for buffers, and in UTF-16 code units for strings
+		int getOffset(const StringPiece& subject, const char* at) const {
+			size_t offset = at - subject.data();
+			if (!isBuffer && !isAscii) {
+				offset = getUtf16Length(subject.data(), at);
+			}
+			return static_cast<int>(offset);
+		}
+
+		size_t count;
+		bool   valid;
+
+	private:
+		Local<Array>   array;
+		const char*    base;
+		const int32_t* offsets;
+		unique_ptr<Nan::TypedArrayContents<int32_t> > boundaries;
+		vector<char>   buffer;
+		bool           isBuffer, isAscii;
+};
+
+
+template <class T>
+static T* getData(const Local<ArrayBuffer>& buffer) {
+	return static_cast<T*>(getArrayBufferData(buffer));
+}
+
+
+NAN_METHOD(WrappedRE2::TestMany) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+
+	Subjects subjects(info[0], info[1]);
+	if (!subjects.valid) {
+		return;
+	}
+
+	// actual work
+
+	Local<ArrayBuffer> buffer = ArrayBuffer::New(Isolate::GetCurrent(), subjects.count);
+	uint8_t* result = getData<uint8_t>(buffer);
+
+	RE2::Anchor anchor = re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED;
+	StringPiece subject;
+
+	for (size_t i = 0; i < subjects.count; ++i) {
+		if (!subjects.get(i, subject)) {
+			return;
+		}
+		result[i] = re2->match(subject, 0, subject.size(), anchor, NULL, 0) ? 1 : 0;
+	}
+
+	// form a result
+
+	info.GetReturnValue().Set(Uint8Array::New(buffer, 0, subjects.count));
+}
+
+
+NAN_METHOD(WrappedRE2::SearchMany) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+
+	Subjects subjects(info[0], info[1]);
+	if (!subjects.valid) {
+		return;
+	}
+
+	// actual work
+
+	Local<ArrayBuffer> buffer = ArrayBuffer::New(Isolate::GetCurrent(), subjects.count * sizeof(int32_t));
+	int32_t* result = getData<int32_t>(buffer);
+
+	RE2::Anchor anchor = re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED;
+	StringPiece subject, match;
+
+	for (size_t i = 0; i < subjects.count; ++i) {
+		if (!subjects.get(i, subject)) {
+			return;
+		}
+		result[i] = re2->match(subject, 0, subject.size(), anchor, &match, 1) ? subjects.getOffset(subject, match.data()) : -1;
+	}
+
+	// form a result
+
+	info.GetReturnValue().Set(Int32Array::New(buffer, 0, subjects.count));
+}
+
+
+NAN_METHOD(WrappedRE2::ExecMany) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+
+	Subjects subjects(info[0], info[1]);
+	if (!subjects.valid) {
+		return;
+	}
+
+	// actual work: every subject takes a [start, end) pair for each group, -1 for unmatched groups
+
+	vector<StringPiece> groups(re2->regexp->NumberOfCapturingGroups() + 1);
+	size_t stride = groups.size() * 2, total = subjects.count * stride;
+
+	Local<ArrayBuffer> buffer = ArrayBuffer::New(Isolate::GetCurrent(), total * sizeof(int32_t));
+	int32_t* result = getData<int32_t>(buffer);
+
+	RE2::Anchor anchor = re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED;
+	StringPiece subject;
+
+	for (size_t i = 0; i < subjects.count; ++i) {
+		if (!subjects.get(i, subject)) {
+			return;
+		}
+		int32_t* spans = result + i * stride;
+		if (!re2->match(subject, 0, subject.size(), anchor, &groups[0], groups.size())) {
+			fill(spans, spans + stride, -1);
+			continue;
+		}
+		for (size_t j = 0, n = groups.size(); j < n; ++j) {
+			const StringPiece& item = groups[j];
+			if (item.data() == NULL) {
+				spans[2 * j] = spans[2 * j + 1] = -1;
+				continue;
+			}
+			spans[2 * j]     = subjects.getOffset(subject, item.data());
+			spans[2 * j + 1] = subjects.getOffset(subject, item.data() + item.size());
+		}
+	}
+
+	// form a result
+
+	info.GetReturnValue().Set(Int32Array::New(buffer, 0, total));
+}
@@ -4,9 +4,6 @@
 #include <vector>
 
 
-using std::map;
-using std::pair;
-using std::string;
 using std::vector;
 
 using v8::Array;
@@ -47,7 +44,7 @@ NAN_METHOD(WrappedRE2::Match) {
 			anchor = RE2::ANCHOR_START;
 		}
 
-		while (re2->regexp.Match(str, lastIndex, a.size, anchor, &match, 1)) {
+		while (re2->match(str, lastIndex, a.size, anchor, &match, 1)) {
 			groups.push_back(match);
 			lastIndex = match.data() - a.data + match.size();
 		}
@@ -60,14 +57,12 @@ NAN_METHOD(WrappedRE2::Match) {
 		// non-global: just like exec()
 
 		if (re2->sticky) {
-			for (size_t n = re2->lastIndex; n; --n) {
-				lastIndex += getUtf8CharSize(a.data[lastIndex]);
-			}
+			lastIndex = a.getUtf8Offset(re2->lastIndex);
 			anchor = RE2::ANCHOR_START;
 		}
 
-		groups.resize(re2->regexp.NumberOfCapturingGroups() + 1);
-		if (!re2->regexp.Match(str, lastIndex, a.size, anchor, &groups[0], groups.size())) {
+		groups.resize(re2->regexp->NumberOfCapturingGroups() + 1);
+		if (!re2->match(str, lastIndex, a.size, anchor, &groups[0], groups.size())) {
 			if (re2->sticky) {
 				re2->lastIndex = 0;
 			}
@@ -78,57 +73,30 @@ NAN_METHOD(WrappedRE2::Match) {
 
 	// form a result
 
+	if (!re2->global) {
+		Local<Array> result = formExecResult(re2, a, &groups[0], groups.size(), info[0]);
+		if (re2->sticky) {
+			re2->lastIndex = a.getUtf16Offset(groups[0].data() - a.data + groups[0].size());
+		}
+		info.GetReturnValue().Set(result);
+		return;
+	}
+
 	Local<Array> result = Nan::New<Array>();
 
 	if (a.isBuffer) {
 		for (size_t i = 0, n = groups.size(); i < n; ++i) {
 			const StringPiece& item = groups[i];
-			if (item.data() != NULL) {
-				Nan::Set(result, i, Nan::CopyBuffer(item.data(), item.size()).ToLocalChecked());
-			}
-		}
-		if (!re2->global) {
-			Nan::Set(result, Nan::New("index").ToLocalChecked(), Nan::New<Integer>(static_cast<int>(groups[0].data() - a.data)));
-			Nan::Set(result, Nan::New("input").ToLocalChecked(), info[0]);
+			Nan::Set(result, i, Nan::CopyBuffer(item.data(), item.size()).ToLocalChecked());
 		}
 	} else {
 		for (size_t i = 0, n = groups.size(); i < n; ++i) {
 			const StringPiece& item = groups[i];
-			if (item.data() != NULL) {
-				Nan::Set(result, i, Nan::New(item.data(), item.size()).ToLocalChecked());
-			}
-		}
-		if (!re2->global) {
-			Nan::Set(result, Nan::New("index").ToLocalChecked(), Nan::New<Integer>(static_cast<int>(getUtf16Length(a.data, groups[0].data()))));
-			Nan::Set(result, Nan::New("input").ToLocalChecked(), info[0]);
+			Nan::Set(result, i, Nan::New(item.data(), item.size()).ToLocalChecked());
 		}
 	}
 
-	if (re2->global) {
-		re2->lastIndex = 0;
-	} else if (re2->sticky) {
-		re2->lastIndex += a.isBuffer ? groups[0].data() - a.data + groups[0].size() - lastIndex :
-			getUtf16Length(a.data + lastIndex, groups[0].data() + groups[0].size());
-	}
-
-	if (!re2->global) {
-		const map<int, string>& groupNames = re2->regexp.CapturingGroupNames();
-		if (!groupNames.empty()) {
-			Local<Object> groups = Nan::New<Object>();
-			auto ignore(groups->SetPrototype(v8::Isolate::GetCurrent()->GetCurrentContext(), Nan::Null()));
-
-			for (pair<int, string> group: groupNames) {
-				Nan::MaybeLocal<Value> value = Nan::Get(result, group.first);
-				if (!value.IsEmpty()) {
-					Nan::Set(groups, Nan::New(group.second).ToLocalChecked(), value.ToLocalChecked());
-				}
-			}
-
-			Nan::Set(result, Nan::New("groups").ToLocalChecked(), groups);
-		} else {
-			Nan::Set(result, Nan::New("groups").ToLocalChecked(), Nan::Undefined());
-		}
-	}
+	re2->lastIndex = 0;
 
 	info.GetReturnValue().Set(result);
 }
@@ -0,0 +1,136 @@
+#include "./wrapped_re2.h"
+#include "./wrapped_re2_match_iterator.h"
+#include "./util.h"
+
+
+using v8::Array;
+using v8::Local;
+using v8::Object;
+using v8::Value;
+
+
+NAN_METHOD(WrappedRE2::MatchAll) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+
+	if (!re2->global) {
+		return Nan::ThrowTypeError("matchAll() requires a global RE2 object.");
+	}
+
+	// form a result
+
+	Nan::MaybeLocal<Object> iterator = WrappedRE2MatchIterator::Create(info.This(), info[0]);
+	if (!iterator.IsEmpty()) {
+		info.GetReturnValue().Set(iterator.ToLocalChecked());
+	}
+}
+
+
+Nan::MaybeLocal<Object> WrappedRE2MatchIterator::Create(const Local<Object>& regexp, const Local<Value>& input) {
+	Nan::MaybeLocal<Object> maybeIterator = Nan::NewInstance(Nan::New<Function>(constructor));
+	if (maybeIterator.IsEmpty()) {
+		return maybeIterator;
+	}
+
+	Local<Object> iterator = maybeIterator.ToLocalChecked();
+	WrappedRE2MatchIterator* self = Nan::ObjectWrap::Unwrap<WrappedRE2MatchIterator>(iterator);
+
+	self->str.reset(new StrVal(input));
+	if (!self->str->data) {
+		return Nan::MaybeLocal<Object>();
+	}
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(regexp);
+	self->re2 = re2;
+	self->regexp.Reset(regexp);
+	self->input.Reset(input);
+	self->groups.resize(re2->regexp->NumberOfCapturingGroups() + 1);
+
+	// like String.prototype.matchAll(): start from lastIndex of the original object, but do not update it
+	if (re2->lastIndex > self->str->length) {
+		self->finish();
+	} else if (re2->lastIndex) {
+		self->lastIndex = self->str->getUtf8Offset(re2->lastIndex);
+	}
+
+	return iterator;
+}
+
+
+void WrappedRE2MatchIterator::finish() {
+	// release the subject and the regular expression as soon as possible
+	done = true;
+	str.reset();
+	regexp.Reset();
+	input.Reset();
+	re2 = NULL;
+}
+
+
+NAN_METHOD(WrappedRE2MatchIterator::New) {
+
+	if (!info.IsConstructCall()) {
+		return Nan::ThrowTypeError("Use RE2.prototype.matchAll() to create an iterator.");
+	}
+
+	WrappedRE2MatchIterator* iterator = new WrappedRE2MatchIterator();
+	iterator->Wrap(info.This());
+	info.GetReturnValue().Set(info.This());
+}
+
+
+NAN_METHOD(WrappedRE2MatchIterator::Next) {
+
+	// unpack arguments
+
+	WrappedRE2MatchIterator* self = Nan::ObjectWrap::Unwrap<WrappedRE2MatchIterator>(info.This());
+	if (!self) {
+		return Nan::ThrowTypeError("RE2 match iterator was expected.");
+	}
+
+	Local<Object> result = Nan::New<Object>();
+
+	if (self->done || !self->re2) {
+		Nan::Set(result, getKey(KEY_VALUE), Nan::Undefined());
+		Nan::Set(result, getKey(KEY_DONE), Nan::True());
+		info.GetReturnValue().Set(result);
+		return;
+	}
+
+	// actual work
+
+	const StrVal& str = *self->str;
+	WrappedRE2* re2 = self->re2;
+	std::vector<StringPiece>& groups = self->groups;
+
+	if (self->lastIndex > str.size || !re2->match(str, self->lastIndex, str.size,
+			re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED, &groups[0], groups.size())) {
+		self->finish();
+		Nan::Set(result, getKey(KEY_VALUE), Nan::Undefined());
+		Nan::Set(result, getKey(KEY_DONE), Nan::True());
+		info.GetReturnValue().Set(result);
+		return;
+	}
+
+	// advance past the match, empty matches advance by one character
+	size_t end = groups[0].data() - str.data + groups[0].size();
+	self->lastIndex = groups[0].size() ? end : end + (end < str.size ? getUtf8CharSize(str.data[end]) : 1);
+
+	// form a result
+
+	Local<Array> value = formExecResult(re2, str, &groups[0], groups.size(), Nan::New(self->input));
+
+	Nan::Set(result, getKey(KEY_VALUE), value);
+	Nan::Set(result, getKey(KEY_DONE), Nan::False());
+	info.GetReturnValue().Set(result);
+}
+
+
+NAN_METHOD(WrappedRE2MatchIterator::Self) {
+	info.GetReturnValue().Set(info.This());
+}
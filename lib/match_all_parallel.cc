@@ -0,0 +1,289 @@
+#include "./wrapped_re2.h"
+#include "./util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <node_buffer.h>
+
+
+using std::max;
+using std::min;
+using std::vector;
+
+using v8::ArrayBuffer;
+using v8::Float64Array;
+using v8::Isolate;
+using v8::Local;
+using v8::Object;
+using v8::String;
+using v8::Value;
+
+
+// matchAllParallel(buffer, options): a buffer is split into pieces, which are scanned concurrently
+// with the shared compiled program, and their matches are merged in order.
+//
+// Pieces end at record boundaries (after a separator byte), and matches are assumed not to cross them,
+// or, if maxMatchLength is specified, pieces end anywhere (at UTF-8 character boundaries), and every scan looks
+// maxMatchLength bytes past its piece. A piece scan reports only matches, which start inside the piece.
+// Its first match can differ from a sequential scan, when a previous match crosses the boundary,
+// so pieces are resynchronized, when merged: a sequential scan continues from the end of the previous match,
+// until it reaches a position, where the piece scan resumed too. From there on both scans are identical.
+
+struct ParallelOptions {
+	size_t threads, maxMatchLength, minSize;
+	char   separator;
+	bool   overlap;
+
+	ParallelOptions() : threads(std::thread::hardware_concurrency()), maxMatchLength(0), minSize(1 << 20), separator('\n'), overlap(false) {
+		if (!threads) {
+			threads = 1;
+		}
+	}
+};
+
+struct Piece {
+	size_t         from, to;
+	vector<size_t> spans; // [start, end) pairs
+	double         nanoseconds;
+};
+
+
+// a position, where scanning continues after a match: empty matches advance by one character
+static size_t resumeAt(const StringPiece& text, size_t start, size_t end) {
+	return end > start ? end : end + (end < text.size() ? getUtf8CharSize(text.data()[end]) : 1);
+}
+
+static size_t getEndPos(const StringPiece& text, const ParallelOptions& options, const Piece& piece) {
+	return options.overlap ? min(text.size(), piece.to + options.maxMatchLength) : piece.to;
+}
+
+static void scanPiece(WrappedRE2* re2, const StringPiece& text, const ParallelOptions& options, Piece& piece) {
+	std::chrono::steady_clock::time_point from = std::chrono::steady_clock::now();
+
+	size_t size = text.size(), endpos = getEndPos(text, options, piece), pos = piece.from;
+	StringPiece match;
+	while (pos <= endpos && re2->match(text, pos, endpos, RE2::UNANCHORED, &match, 1)) {
+		size_t start = match.data() - text.data(), end = start + match.size();
+		// the last piece takes an empty match at the end of a buffer too
+		if (start >= piece.to && piece.to < size) {
+			break;
+		}
+		piece.spans.push_back(start);
+		piece.spans.push_back(end);
+		pos = resumeAt(text, start, end);
+	}
+
+	piece.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - from).count();
+}
+
+static void splitIntoPieces(const StringPiece& text, const ParallelOptions& options, size_t count, vector<Piece>& pieces) {
+	const char* data = text.data();
+	size_t size = text.size(), step = max(size / count, static_cast<size_t>(1)), from = 0;
+	while (from < size) {
+		size_t to = count > 1 && size - from > step ? from + step : size;
+		if (to < size) {
+			if (options.overlap) {
+				// do not split UTF-8 characters
+				while (to < size && (data[to] & 0xC0) == 0x80) {
+					++to;
+				}
+			} else {
+				const char* found = static_cast<const char*>(memchr(data + to, options.separator, size - to));
+				to = found ? found - data + 1 : size;
+			}
+		}
+		Piece piece;
+		piece.from = from;
+		piece.to   = to;
+		piece.nanoseconds = 0;
+		pieces.push_back(piece);
+		from = to;
+	}
+	if (pieces.empty()) {
+		Piece piece;
+		piece.from = piece.to = 0;
+		piece.nanoseconds = 0;
+		pieces.push_back(piece);
+	}
+}
+
+// merges piece matches into [offset, length] pairs
+static void mergePieces(WrappedRE2* re2, const StringPiece& text, const ParallelOptions& options, const vector<Piece>& pieces, vector<double>& result) {
+	size_t size = text.size(), pos = 0;
+	StringPiece match;
+
+	for (size_t i = 0; i < pieces.size(); ++i) {
+		const Piece& piece = pieces[i];
+		const vector<size_t>& spans = piece.spans;
+		size_t n = spans.size() / 2, next = 0;
+		bool synced = pos <= piece.from;
+
+		// resynchronize with a sequential scan
+		size_t endpos = options.overlap ? getEndPos(text, options, piece) : size;
+		while (!synced) {
+			while (next < n && resumeAt(text, spans[2 * next], spans[2 * next + 1]) < pos) {
+				++next;
+			}
+			if (next < n && resumeAt(text, spans[2 * next], spans[2 * next + 1]) == pos) {
+				++next;
+				synced = true;
+				break;
+			}
+			if (pos > endpos || !re2->match(text, pos, endpos, RE2::UNANCHORED, &match, 1)) {
+				break;
+			}
+			size_t start = match.data() - text.data(), end = start + match.size();
+			if (start >= piece.to && piece.to < size) {
+				break;
+			}
+			result.push_back(start);
+			result.push_back(end - start);
+			pos = resumeAt(text, start, end);
+		}
+
+		if (!synced) {
+			// nothing else starts in this piece
+			pos = max(pos, piece.to);
+			continue;
+		}
+
+		for (; next < n; ++next) {
+			size_t start = spans[2 * next], end = spans[2 * next + 1];
+			result.push_back(start);
+			result.push_back(end - start);
+			pos = resumeAt(text, start, end);
+		}
+		pos = max(pos, piece.to);
+	}
+}
+
+
+// returns false, if an exception was thrown
+static bool getParallelOptions(const Local<Value>& arg, ParallelOptions& options) {
+	if (!arg->IsObject()) {
+		return true;
+	}
+	Local<Object> object(arg.As<Object>());
+
+	Local<Value> threads(Nan::Get(object, Nan::New("threads").ToLocalChecked()).ToLocalChecked());
+	if (!threads->IsUndefined()) {
+		double n = threads->IsNumber() ? threads.As<v8::Number>()->Value() : 0;
+		if (!(n >= 1 && n <= 256)) {
+			Nan::ThrowRangeError("threads should be a number from 1 to 256.");
+			return false;
+		}
+		options.threads = static_cast<size_t>(n);
+	}
+
+	Local<Value> maxMatchLength(Nan::Get(object, Nan::New("maxMatchLength").ToLocalChecked()).ToLocalChecked());
+	if (!maxMatchLength->IsUndefined()) {
+		double n = maxMatchLength->IsNumber() ? maxMatchLength.As<v8::Number>()->Value() : 0;
+		if (!(n >= 1 && n <= 0x7FFFFFFF)) {
+			Nan::ThrowRangeError("maxMatchLength should be a positive number of bytes.");
+			return false;
+		}
+		options.maxMatchLength = static_cast<size_t>(n);
+		options.overlap = true;
+	}
+
+	Local<Value> separator(Nan::Get(object, Nan::New("separator").ToLocalChecked()).ToLocalChecked());
+	if (!separator->IsUndefined()) {
+		if (!separator->IsString() || separator.As<String>()->Length() != 1 || utf8Length(separator.As<String>()) != 1) {
+			Nan::ThrowTypeError("separator should be a single ASCII character.");
+			return false;
+		}
+		Nan::Utf8String s(separator);
+		options.separator = (*s)[0];
+	}
+
+	Local<Value> minSize(Nan::Get(object, Nan::New("minSize").ToLocalChecked()).ToLocalChecked());
+	if (!minSize->IsUndefined()) {
+		double n = minSize->IsNumber() ? minSize.As<v8::Number>()->Value() : -1;
+		if (!(n >= 0)) {
+			Nan::ThrowRangeError("minSize should be a non-negative number of bytes.");
+			return false;
+		}
+		options.minSize = n < 9e15 ? static_cast<size_t>(n) : static_cast<size_t>(-1);
+	}
+
+	return true;
+}
+
+
+NAN_METHOD(WrappedRE2::MatchAllParallel) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+
+	if (!node::Buffer::HasInstance(info[0])) {
+		return Nan::ThrowTypeError("A buffer was expected.");
+	}
+
+	ParallelOptions options;
+	if (!getParallelOptions(info[1], options)) {
+		return;
+	}
+
+	StringPiece text(node::Buffer::Data(info[0]), node::Buffer::Length(info[0]));
+
+	// actual work
+
+	std::chrono::steady_clock::time_point from = std::chrono::steady_clock::now();
+
+	// small inputs are scanned sequentially: starting threads costs more than it saves
+	size_t threads = text.size() < options.minSize ? 1 : options.threads;
+
+	// there are more pieces than threads, so threads, which are done early, take over remaining pieces
+	vector<Piece> pieces;
+	splitIntoPieces(text, options, threads > 1 ? threads * 4 : 1, pieces);
+	threads = min(threads, pieces.size());
+
+	std::atomic<size_t> nextPiece(0);
+	auto work = [&]() {
+		for (size_t i; (i = nextPiece.fetch_add(1)) < pieces.size();) {
+			scanPiece(re2, text, options, pieces[i]);
+		}
+	};
+
+	vector<std::thread> pool;
+	for (size_t i = 1; i < threads; ++i) {
+		pool.push_back(std::thread(work));
+	}
+	work(); // the main thread works too
+	for (size_t i = 0; i < pool.size(); ++i) {
+		pool[i].join();
+	}
+
+	vector<double> spans;
+	mergePieces(re2, text, options, pieces, spans);
+
+	double time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - from).count(), busy = 0;
+	for (size_t i = 0; i < pieces.size(); ++i) {
+		busy += pieces[i].nanoseconds;
+	}
+
+	// form a result
+
+	Local<ArrayBuffer> buffer = ArrayBuffer::New(Isolate::GetCurrent(), spans.size() * sizeof(double));
+	if (!spans.empty()) {
+		memcpy(getArrayBufferData(buffer), &spans[0], spans.size() * sizeof(double));
+	}
+
+	Local<Object> result = Nan::New<Object>();
+	Nan::Set(result, Nan::New("spans").ToLocalChecked(),      Float64Array::New(buffer, 0, spans.size()));
+	Nan::Set(result, Nan::New("threads").ToLocalChecked(),    Nan::New<v8::Number>(static_cast<double>(threads)));
+	Nan::Set(result, Nan::New("pieces").ToLocalChecked(),     Nan::New<v8::Number>(static_cast<double>(pieces.size())));
+	Nan::Set(result, Nan::New("time").ToLocalChecked(),       Nan::New<v8::Number>(time / 1e6));
+	// the fraction of the ideal speedup: 1 means, that all threads were busy scanning all the time
+	Nan::Set(result, Nan::New("efficiency").ToLocalChecked(), Nan::New<v8::Number>(time > 0 ? min(1.0, busy / (time * threads)) : 1.0));
+
+	info.GetReturnValue().Set(result);
+}
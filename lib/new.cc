@@ -1,5 +1,7 @@
 #include "./wrapped_re2.h"
 #include "./util.h"
+#include "./pattern_cache.h"
+#include "./shared_registry.h"
 
 #include <memory>
 #include <string>
@@ -9,12 +11,15 @@
 
 using std::map;
 using std::pair;
+using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
 using std::unordered_set;
 using std::vector;
 
 using v8::Local;
+using v8::MaybeLocal;
+using v8::Object;
 using v8::RegExp;
 using v8::String;
 using v8::Value;
@@ -30,7 +35,7 @@ inline bool isHexadecimal(char ch) {
 	return ('0' <= ch && ch <= '9') || ('A' <= ch && ch <= 'Z') || ('a' <= ch && ch <= 'z');
 }
 
-static bool translateRegExp(const char* data, size_t size, vector<char>& buffer) {
+bool translateRegExp(const char* data, size_t size, vector<char>& buffer) {
 	string result;
 	bool changed = false;
 
@@ -128,7 +133,7 @@ static bool translateRegExp(const char* data, size_t size, vector<char>& buffer)
 	return true;
 }
 
-static string escapeRegExp(const char* data, size_t size) {
+string escapeRegExp(const char* data, size_t size) {
 	string result;
 
 	if (!size) {
@@ -175,6 +180,84 @@ inline bool ensureUniqueNamedGroups(const map<int, string>& groups) {
 }
 
 
+// an options object: {maxMem, longestMatch, literal, neverNL, dotNL, posixSyntax}, all optional
+
+static MaybeLocal<Value> getOption(const Local<Object>& object, const char* name) {
+	return Nan::Get(object, Nan::New(name).ToLocalChecked());
+}
+
+static bool parseOptions(const Local<Value>& arg, RE2::Options& options) {
+	if (arg->IsUndefined() || arg->IsNull()) {
+		return true;
+	}
+	if (!arg->IsObject()) {
+		Nan::ThrowTypeError("An options object was expected.");
+		return false;
+	}
+	Local<Object> object(arg.As<Object>());
+
+	MaybeLocal<Value> t(getOption(object, "maxMem"));
+	if (t.IsEmpty()) {
+		return false;
+	}
+	Local<Value> maxMem(t.ToLocalChecked());
+	if (!maxMem->IsUndefined()) {
+		double value = maxMem->IsNumber() ? maxMem.As<v8::Number>()->Value() : 0;
+		if (!(value > 0 && value < 9e15)) {
+			Nan::ThrowRangeError("maxMem should be a positive number of bytes.");
+			return false;
+		}
+		options.set_max_mem(static_cast<int64_t>(value));
+	}
+
+	static const struct {
+		const char* name;
+		void (RE2::Options::*set)(bool);
+	} flags[] = {
+		{"longestMatch", &RE2::Options::set_longest_match},
+		{"literal",      &RE2::Options::set_literal},
+		{"neverNL",      &RE2::Options::set_never_nl},
+		{"dotNL",        &RE2::Options::set_dot_nl},
+		{"posixSyntax",  &RE2::Options::set_posix_syntax}
+	};
+	for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); ++i) {
+		MaybeLocal<Value> t(getOption(object, flags[i].name));
+		if (t.IsEmpty()) {
+			return false;
+		}
+		Local<Value> value(t.ToLocalChecked());
+		if (!value->IsUndefined()) {
+			(options.*flags[i].set)(Nan::To<bool>(value).FromJust());
+		}
+	}
+
+	return true;
+}
+
+
+// ids of shared programs are small sequential numbers, so any object with a sharedId can name an unrelated program:
+// a program is used only when it is the one described by a handle, otherwise the handle is compiled as is.
+// Returns false, if an exception was thrown.
+
+static bool verifySharedProgram(SharedHandle& handle) {
+	if (!handle.regexp) {
+		return true;
+	}
+	RE2::Options options;
+	if (!parseOptions(handle.options, options)) {
+		return false;
+	}
+	const RE2::Options& actual = handle.regexp->options();
+	if (handle.regexp->pattern() != handle.pattern || actual.max_mem() != options.max_mem() ||
+			actual.longest_match() != options.longest_match() || actual.literal() != options.literal() ||
+			actual.never_nl() != options.never_nl() || actual.dot_nl() != options.dot_nl() ||
+			actual.posix_syntax() != options.posix_syntax()) {
+		handle.regexp.reset();
+	}
+	return true;
+}
+
+
 NAN_METHOD(WrappedRE2::New) {
 
 	if (!info.IsConstructCall()) {
@@ -204,18 +287,33 @@ NAN_METHOD(WrappedRE2::New) {
 	bool   multiline = false;
 	bool   unicode = false;
 	bool   sticky = false;
+	bool   hasFlags = false;
+
+	shared_ptr<const RE2> parent;
+	Local<Value>          sharedOptions = Nan::Undefined();
+
+	// options are the last argument: new RE2(pattern, options), or new RE2(pattern, flags, options)
+
+	Local<Value> optionsArg = Nan::Undefined();
+	if (info.Length() > 2) {
+		optionsArg = info[2];
+	} else if (info.Length() > 1 && info[1]->IsObject() && !node::Buffer::HasInstance(info[1])) {
+		optionsArg = info[1];
+	}
+	bool hasOptions = !optionsArg->IsUndefined() && !optionsArg->IsNull();
 
 	if (info.Length() > 1) {
 		if (info[1]->IsString()) {
-			Local<String> t(info[1]->ToString());
-			buffer.resize(t->Utf8Length() + 1);
-			t->WriteUtf8(&buffer[0]);
+			Local<String> t(info[1].As<String>());
+			buffer.resize(utf8Length(t) + 1);
+			writeUtf8Chars(t, &buffer[0]);
 			size = buffer.size() - 1;
 			data = &buffer[0];
 		} else if (node::Buffer::HasInstance(info[1])) {
 			size = node::Buffer::Length(info[1]);
 			data = node::Buffer::Data(info[1]);
 		}
+		hasFlags = data != NULL;
 		for (size_t i = 0; i < size; ++i) {
 			switch (data[i]) {
 				case 'g':
@@ -248,8 +346,8 @@ NAN_METHOD(WrappedRE2::New) {
 		const RegExp* re = RegExp::Cast(*info[0]);
 
 		Local<String> t(re->GetSource());
-		buffer.resize(t->Utf8Length() + 1);
-		t->WriteUtf8(&buffer[0]);
+		buffer.resize(utf8Length(t) + 1);
+		writeUtf8Chars(t, &buffer[0]);
 		size = buffer.size() - 1;
 		data = &buffer[0];
 		source = escapeRegExp(data, size);
@@ -262,36 +360,66 @@ NAN_METHOD(WrappedRE2::New) {
 		sticky     = bool(flags & RegExp::kSticky);
 	} else if (info[0]->IsObject() && !info[0]->IsString()) {
 		WrappedRE2* re2 = NULL;
-		auto object = info[0]->ToObject();
-		if (!object.IsEmpty() && object->InternalFieldCount() > 0) {
+		Local<Object> object(info[0].As<Object>());
+		if (!object.IsEmpty() && WrappedRE2::HasInstance(object)) {
 			re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(object);
 		}
 		if (re2) {
-			const string& pattern = re2->regexp.pattern();
+			const string& pattern = re2->regexp->pattern();
 			size = pattern.size();
 			buffer.resize(size);
 			data = &buffer[0];
 			memcpy(data, pattern.data(), size);
 			needConversion = false;
 
-			source     = re2->source;
-			global     = re2->global;
-			ignoreCase = re2->ignoreCase;
-			multiline  = re2->multiline;
-			unicode    = true;
-			sticky     = re2->sticky;
+			source  = re2->source;
+			unicode = true;
+			parent  = re2->regexp;
+
+			if (!hasFlags) {
+				global     = re2->global;
+				ignoreCase = re2->ignoreCase;
+				multiline  = re2->multiline;
+				sticky     = re2->sticky;
+			}
+		} else if (!object.IsEmpty()) {
+			// a handle created by share(), possibly in another isolate
+			SharedHandle shared;
+			if (unpackSharedHandle(object, shared)) {
+				if (!verifySharedProgram(shared)) {
+					return;
+				}
+
+				size = shared.pattern.size();
+				buffer.resize(size + 1);
+				data = &buffer[0];
+				memcpy(data, shared.pattern.data(), size);
+				needConversion = false;
+
+				source  = shared.source;
+				unicode = true;
+				parent  = shared.regexp;
+				sharedOptions = shared.options;
+
+				if (!hasFlags) {
+					global     = shared.global;
+					ignoreCase = shared.ignoreCase;
+					multiline  = shared.multiline;
+					sticky     = shared.sticky;
+				}
+			}
 		}
 	} else if (info[0]->IsString()) {
-		Local<String> t(info[0]->ToString());
-		buffer.resize(t->Utf8Length() + 1);
-		t->WriteUtf8(&buffer[0]);
+		Local<String> t(info[0].As<String>());
+		buffer.resize(utf8Length(t) + 1);
+		writeUtf8Chars(t, &buffer[0]);
 		size = buffer.size() - 1;
 		data = &buffer[0];
 		source = escapeRegExp(data, size);
 	}
 
 	if (!data) {
-		return Nan::ThrowTypeError("Expected string, Buffer, RegExp, or RE2 as the 1st argument.");
+		return Nan::ThrowTypeError("Expected string, Buffer, RegExp, RE2, or a shared handle as the 1st argument.");
 	}
 
 	if (!unicode) {
@@ -312,25 +440,46 @@ NAN_METHOD(WrappedRE2::New) {
 		}
 	}
 
-	if (needConversion && translateRegExp(data, size, buffer)) {
+	// clones inherit options of their originals, shared handles carry options of their programs
+
+	RE2::Options options;
+	if (parent) {
+		options.Copy(parent->options());
+	} else if (!parseOptions(sharedOptions, options)) {
+		return;
+	}
+	if (!parseOptions(optionsArg, options)) {
+		return;
+	}
+	options.set_case_sensitive(!ignoreCase);
+	options.set_one_line(!multiline);
+	options.set_log_errors(false); // inappropriate when embedding
+
+	// a literal pattern is used as is
+	if (needConversion && !options.literal() && translateRegExp(data, size, buffer)) {
 		size = buffer.size() - 1;
 		data = &buffer[0];
 	}
 
 	// create and return an object
 
-	RE2::Options options;
-	options.set_case_sensitive(!ignoreCase);
-	options.set_one_line(!multiline);
-	options.set_log_errors(false); // inappropriate when embedding
+	shared_ptr<const RE2> regexp;
+
+	if (parent && !hasOptions && parent->options().case_sensitive() == !ignoreCase && parent->options().one_line() == !multiline) {
+		// a clone, which differs only in global or sticky flags: they do not affect a compiled program
+		regexp = parent;
+	} else {
+		regexp = PatternCache::get(StringPiece(data, size), options);
+	}
 
-	unique_ptr<WrappedRE2> re2(new WrappedRE2(StringPiece(data, size), options, source, global, ignoreCase, multiline, sticky));
-	if (!re2->regexp.ok()) {
-		return Nan::ThrowSyntaxError(re2->regexp.error().c_str());
+	unique_ptr<WrappedRE2> re2(new WrappedRE2(regexp, source, global, ignoreCase, multiline, sticky));
+	if (!re2->regexp->ok()) {
+		return Nan::ThrowSyntaxError(re2->regexp->error().c_str());
 	}
-	if (!ensureUniqueNamedGroups(re2->regexp.CapturingGroupNames())) {
+	if (!ensureUniqueNamedGroups(re2->regexp->CapturingGroupNames())) {
 		return Nan::ThrowSyntaxError("duplicate capture group name");
 	}
+	re2->prepareResultShape();
 	re2->Wrap(info.This());
 	re2.release();
 
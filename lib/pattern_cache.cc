@@ -0,0 +1,154 @@
+#include "./pattern_cache.h"
+#include "./wrapped_re2.h"
+
+#include <cstring>
+
+
+using std::lock_guard;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::unordered_map;
+
+using v8::Local;
+using v8::Object;
+
+
+mutex                                                  PatternCache::guard;
+PatternCache::Entries                                  PatternCache::entries;
+unordered_map<string, PatternCache::Entries::iterator> PatternCache::index;
+
+size_t PatternCache::capacity  = PatternCache::defaultCapacity;
+size_t PatternCache::hits      = 0;
+size_t PatternCache::misses    = 0;
+size_t PatternCache::evictions = 0;
+
+
+// a key is a fixed-size prefix of encoded options followed by pattern bytes
+
+string PatternCache::makeKey(const StringPiece& pattern, const RE2::Options& options) {
+	int64_t maxMem = options.max_mem();
+	unsigned flags =
+		(options.encoding() == RE2::Options::EncodingLatin1 ? 1 : 0) |
+		(options.posix_syntax()   ?    2 : 0) |
+		(options.longest_match()  ?    4 : 0) |
+		(options.literal()        ?    8 : 0) |
+		(options.never_nl()       ?   16 : 0) |
+		(options.dot_nl()         ?   32 : 0) |
+		(options.never_capture()  ?   64 : 0) |
+		(options.case_sensitive() ?  128 : 0) |
+		(options.perl_classes()   ?  256 : 0) |
+		(options.word_boundary()  ?  512 : 0) |
+		(options.one_line()       ? 1024 : 0);
+
+	string key(sizeof(maxMem) + sizeof(flags), '\0');
+	memcpy(&key[0], &maxMem, sizeof(maxMem));
+	memcpy(&key[sizeof(maxMem)], &flags, sizeof(flags));
+	key.append(pattern.data(), pattern.size());
+	return key;
+}
+
+
+void PatternCache::trim() {
+	while (entries.size() > capacity) {
+		index.erase(entries.back().first);
+		entries.pop_back();
+		++evictions;
+	}
+}
+
+
+shared_ptr<const RE2> PatternCache::get(const StringPiece& pattern, const RE2::Options& options) {
+	string key = makeKey(pattern, options);
+
+	{
+		lock_guard<mutex> lock(guard);
+		auto found = index.find(key);
+		if (found != index.end()) {
+			++hits;
+			entries.splice(entries.begin(), entries, found->second);
+			return found->second->second;
+		}
+		++misses;
+	}
+
+	// compile outside of the lock: it is the expensive part
+	shared_ptr<const RE2> regexp = std::make_shared<const RE2>(pattern, options);
+	if (!regexp->ok()) {
+		return regexp;
+	}
+
+	lock_guard<mutex> lock(guard);
+	if (!capacity) {
+		return regexp;
+	}
+	auto found = index.find(key);
+	if (found != index.end()) {
+		// compiled concurrently by someone else: share their copy
+		entries.splice(entries.begin(), entries, found->second);
+		return found->second->second;
+	}
+	entries.emplace_front(key, regexp);
+	index.emplace(std::move(key), entries.begin());
+	trim();
+	return regexp;
+}
+
+
+PatternCache::Stats PatternCache::getStats() {
+	lock_guard<mutex> lock(guard);
+	Stats stats = {entries.size(), capacity, hits, misses, evictions};
+	return stats;
+}
+
+
+void PatternCache::setCapacity(size_t newCapacity) {
+	lock_guard<mutex> lock(guard);
+	capacity = newCapacity;
+	trim();
+}
+
+
+void PatternCache::clear() {
+	lock_guard<mutex> lock(guard);
+	index.clear();
+	entries.clear();
+}
+
+
+// JavaScript interface: RE2.getCacheStats(), RE2.clearCache(), and RE2.cacheCapacity
+
+NAN_METHOD(WrappedRE2::GetCacheStats) {
+	PatternCache::Stats stats = PatternCache::getStats();
+
+	Local<Object> result = Nan::New<Object>();
+	Nan::Set(result, Nan::New("size").ToLocalChecked(),      Nan::New<v8::Number>(stats.size));
+	Nan::Set(result, Nan::New("capacity").ToLocalChecked(),  Nan::New<v8::Number>(stats.capacity));
+	Nan::Set(result, Nan::New("hits").ToLocalChecked(),      Nan::New<v8::Number>(stats.hits));
+	Nan::Set(result, Nan::New("misses").ToLocalChecked(),    Nan::New<v8::Number>(stats.misses));
+	Nan::Set(result, Nan::New("evictions").ToLocalChecked(), Nan::New<v8::Number>(stats.evictions));
+
+	info.GetReturnValue().Set(result);
+}
+
+
+NAN_METHOD(WrappedRE2::ClearCache) {
+	PatternCache::clear();
+}
+
+
+NAN_GETTER(WrappedRE2::GetCacheCapacity) {
+	info.GetReturnValue().Set(Nan::New<v8::Number>(PatternCache::getStats().capacity));
+}
+
+
+NAN_SETTER(WrappedRE2::SetCacheCapacity) {
+	if (!value->IsNumber()) {
+		return Nan::ThrowTypeError("Cache capacity should be a non-negative number.");
+	}
+	double capacity = Nan::To<double>(value).FromJust();
+	if (!(capacity >= 0)) {
+		return Nan::ThrowRangeError("Cache capacity should be a non-negative number.");
+	}
+	PatternCache::setCapacity(capacity < 1e9 ? static_cast<size_t>(capacity) : static_cast<size_t>(1e9));
+}
@@ -0,0 +1,49 @@
+#ifndef PATTERN_CACHE_H_
+#define PATTERN_CACHE_H_
+
+
+#include <re2/re2.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+
+// A process-wide LRU cache of compiled patterns keyed on a translated pattern and RE2 options.
+// Compiled RE2 objects are immutable and thread-safe, so they are shared by all wrappers
+// created with the same pattern and options. Only successfully compiled patterns are cached.
+
+class PatternCache {
+
+	public:
+		struct Stats {
+			size_t size, capacity, hits, misses, evictions;
+		};
+
+		// returns a compiled pattern: a cached one, or a freshly compiled one, which is cached, if it is valid
+		static std::shared_ptr<const re2::RE2> get(const re2::StringPiece& pattern, const re2::RE2::Options& options);
+
+		static Stats getStats();
+		static void  setCapacity(size_t capacity);
+		static void  clear();
+
+		static const size_t defaultCapacity = 1024;
+
+	private:
+		typedef std::pair<std::string, std::shared_ptr<const re2::RE2> > Entry;
+		typedef std::list<Entry> Entries;
+
+		static std::string makeKey(const re2::StringPiece& pattern, const re2::RE2::Options& options);
+		static void trim(); // expects the mutex to be locked
+
+		static std::mutex guard;
+		static Entries    entries; // the most recently used entry goes first
+		static std::unordered_map<std::string, Entries::iterator> index;
+		static size_t     capacity, hits, misses, evictions;
+};
+
+
+#endif
@@ -2,6 +2,7 @@
 #include "./util.h"
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <vector>
@@ -10,9 +11,11 @@
 #include <node_buffer.h>
 
 
+using std::make_shared;
 using std::map;
 using std::min;
 using std::pair;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 using std::unique_ptr;
@@ -25,242 +28,235 @@ using v8::String;
 using v8::Value;
 
 
-inline int getMaxSubmatch(const char* data, size_t size, const map<string, int>& namedGroups) {
-	int maxSubmatch = 0, index, index2;
+// replacement templates
+
+void ReplacementTemplate::addLiteral(size_t offset, size_t size) {
+	if (!size) {
+		return;
+	}
+	literalSize += size;
+	if (!ops.empty()) {
+		Op& last = ops.back();
+		if (last.type == LITERAL && last.offset + last.size == offset) {
+			last.size += size;
+			return;
+		}
+	}
+	Op op = {LITERAL, offset, size, 0};
+	ops.push_back(op);
+}
+
+
+void ReplacementTemplate::addGroup(OpType type, int group) {
+	if (maxGroup < group) {
+		maxGroup = group;
+	}
+	Op op = {type, 0, 0, group};
+	ops.push_back(op);
+}
+
+
+ReplacementTemplate::ReplacementTemplate(const RE2& regexp, const char* data, size_t size) :
+		text(data, size), maxGroup(0), literalSize(0) {
+
+	const map<string, int>& namedGroups = regexp.NamedCapturingGroups();
+	int numberOfGroups = regexp.NumberOfCapturingGroups(), index, index2;
 	const char* nameBegin;
 	const char* nameEnd;
+
 	for (size_t i = 0; i < size;) {
-		char ch = data[i];
-		if (ch == '$') {
-			if (i + 1 < size) {
-				ch = data[i + 1];
-				switch (ch) {
-					case '$':
-					case '&':
-					case '`':
-					case '\'':
-						i += 2;
-						continue;
-					case '0':
-					case '1':
-					case '2':
-					case '3':
-					case '4':
-					case '5':
-					case '6':
-					case '7':
-					case '8':
-					case '9':
-						index = ch - '0';
-						if (i + 2 < size) {
-							ch = data[i + 2];
-							if ('0' <= ch && ch <= '9') {
-								index2 = index * 10 + (ch - '0');
-								if (maxSubmatch < index2) maxSubmatch = index2;
-								i += 3;
-								continue;
+		if (data[i] != '$') {
+			const char* next = (const char*)memchr(data + i, '$', size - i);
+			size_t end = next ? next - data : size;
+			addLiteral(i, end - i);
+			i = end;
+			continue;
+		}
+		if (i + 1 < size) {
+			char ch = data[i + 1];
+			switch (ch) {
+				case '$':
+					addLiteral(i, 1);
+					i += 2;
+					continue;
+				case '&':
+					addGroup(GROUP, 0);
+					i += 2;
+					continue;
+				case '`':
+					addGroup(PREFIX, 0);
+					i += 2;
+					continue;
+				case '\'':
+					addGroup(SUFFIX, 0);
+					i += 2;
+					continue;
+				case '0':
+				case '1':
+				case '2':
+				case '3':
+				case '4':
+				case '5':
+				case '6':
+				case '7':
+				case '8':
+				case '9':
+					index = ch - '0';
+					if (i + 2 < size) {
+						ch = data[i + 2];
+						if ('0' <= ch && ch <= '9') {
+							// two digits are never shortened to one
+							index2 = index * 10 + (ch - '0');
+							if (index2 && index2 <= numberOfGroups) {
+								addGroup(GROUP, index2);
+							} else {
+								addLiteral(i, 3);
 							}
+							i += 3;
+							continue;
 						}
-						if (maxSubmatch < index) maxSubmatch = index;
-						i += 2;
-						continue;
-					case '<':
+					}
+					if (index && index <= numberOfGroups) {
+						addGroup(GROUP, index);
+					} else {
+						addLiteral(i, 2);
+					}
+					i += 2;
+					continue;
+				case '<':
+					if (!namedGroups.empty()) {
 						nameBegin = data + i + 2;
 						nameEnd = (const char*)memchr(nameBegin, '>', size - i - 2);
 						if (nameEnd) {
-							string name(nameBegin, nameEnd - nameBegin);
-							map<string, int>::const_iterator group = namedGroups.find(name);
+							// unknown names are replaced with nothing
+							map<string, int>::const_iterator group = namedGroups.find(string(nameBegin, nameEnd - nameBegin));
 							if (group != namedGroups.end()) {
-								index = group->second;
-								if (maxSubmatch < index) maxSubmatch = index;
+								addGroup(GROUP, group->second);
 							}
 							i = nameEnd + 1 - data;
-						} else {
-							i += 2;
+							continue;
 						}
-						continue;
-				}
+					}
+					addLiteral(i, 2);
+					i += 2;
+					continue;
 			}
-			++i;
-			continue;
 		}
-		i += getUtf8CharSize(ch);
+		addLiteral(i, 1);
+		++i;
 	}
-	return maxSubmatch;
 }
 
 
-inline string replace(const char* data, size_t size, const vector<StringPiece>& groups, const StringPiece& str, const map<string, int>& namedGroups) {
-	string result;
-	size_t index, index2;
-	const char* nameBegin;
-	const char* nameEnd;
-	for (size_t i = 0; i < size;) {
-		char ch = data[i];
-		if (ch == '$') {
-			if (i + 1 < size) {
-				ch = data[i + 1];
-				switch (ch) {
-					case '$':
-						result += ch;
-						i += 2;
-						continue;
-					case '&':
-						result += groups[0].as_string();
-						i += 2;
-						continue;
-					case '`':
-						result += string(str.data(), groups[0].data() - str.data());
-						i += 2;
-						continue;
-					case '\'':
-						result += string(groups[0].data() + groups[0].size(),
-							str.data() + str.size() - groups[0].data() - groups[0].size());
-						i += 2;
-						continue;
-					case '0':
-					case '1':
-					case '2':
-					case '3':
-					case '4':
-					case '5':
-					case '6':
-					case '7':
-					case '8':
-					case '9':
-						index = ch - '0';
-						if (i + 2 < size) {
-							ch = data[i + 2];
-							if ('0' <= ch && ch <= '9') {
-								i += 3;
-								index2 = index * 10 + (ch - '0');
-								if (index2 && index2 < groups.size()) {
-									result += groups[index2].as_string();
-									continue;
-								}
-								result += '$';
-								result += '0' + index;
-								result += ch;
-								continue;
-							}
-							ch = '0' + index;
-						}
-						i += 2;
-						if (index && index < groups.size()) {
-							result += groups[index].as_string();
-							continue;
-						}
-						result += '$';
-						result += ch;
-						continue;
-					case '<':
-						if (!namedGroups.empty()) {
-							nameBegin = data + i + 2;
-							nameEnd = (const char*)memchr(nameBegin, '>', size - i - 2);
-							if (nameEnd) {
-								string name(nameBegin, nameEnd - nameBegin);
-								map<string, int>::const_iterator group = namedGroups.find(name);
-								if (group != namedGroups.end()) {
-									index = group->second;
-									result += groups[index].as_string();
-								}
-								i = nameEnd + 1 - data;
-							} else {
-								result += "$<";
-								i += 2;
-							}
-						} else {
-							result += "$<";
-							i += 2;
-						}
-						continue;
-				}
-			}
-			result += '$';
-			++i;
-			continue;
+void ReplacementTemplate::apply(const StringPiece* groups, const StringPiece& str, OutputBuffer& result) const {
+	const StringPiece& match = groups[0];
+	size_t prefixSize = match.data() - str.data(), suffixSize = str.size() - prefixSize - match.size();
+
+	size_t total = literalSize;
+	for (const Op& op: ops) {
+		switch (op.type) {
+			case LITERAL: break;
+			case GROUP:   total += groups[op.group].size(); break;
+			case PREFIX:  total += prefixSize; break;
+			case SUFFIX:  total += suffixSize; break;
+		}
+	}
+
+	if (!result.reserve(result.size + total)) {
+		return;
+	}
+
+	for (const Op& op: ops) {
+		switch (op.type) {
+			case LITERAL:
+				result.append(text.data() + op.offset, op.size);
+				break;
+			case GROUP:
+				result.append(groups[op.group].data(), groups[op.group].size());
+				break;
+			case PREFIX:
+				result.append(str.data(), prefixSize);
+				break;
+			case SUFFIX:
+				result.append(match.data() + match.size(), suffixSize);
+				break;
 		}
-		size_t sym_size = getUtf8CharSize(ch);
-		result.append(data + i, sym_size);
-		i += sym_size;
 	}
-	return result;
 }
 
 
-static Nan::Maybe<string> replace(WrappedRE2* re2, const StrVal& replacee, const char* replacer, size_t replacer_size) {
-	const StringPiece str(replacee);
+// the last used template is cached, because the same replacement is usually used again
+
+shared_ptr<const ReplacementTemplate> WrappedRE2::getReplacementTemplate(const char* data, size_t size) {
+	if (!replacementTemplate || replacementTemplate->text.size() != size || memcmp(replacementTemplate->text.data(), data, size)) {
+		replacementTemplate = make_shared<const ReplacementTemplate>(*regexp, data, size);
+	}
+	return replacementTemplate;
+}
+
+
+bool replaceWithString(WrappedRE2* re2, const StringPiece& str, size_t lastIndex,
+		const ReplacementTemplate& replacer, OutputBuffer& result, size_t& matchEnd) {
 	const char* data = str.data();
 	size_t      size = str.size();
 
-	const map<string, int>& namedGroups = re2->regexp.NamedCapturingGroups();
-
-	vector<StringPiece> groups(min(re2->regexp.NumberOfCapturingGroups(), getMaxSubmatch(replacer, replacer_size, namedGroups)) + 1);
+	vector<StringPiece> groups(replacer.maxGroup + 1);
 	const StringPiece& match = groups[0];
 
-	size_t lastIndex = 0;
-	string result;
-	RE2::Anchor anchor = RE2::UNANCHORED;
-
-	if (re2->sticky) {
-		if (!re2->global) {
-			if (replacee.isBuffer) {
-				lastIndex = re2->lastIndex;
-			} else {
-				for (size_t n = re2->lastIndex; n; --n) {
-					lastIndex += getUtf8CharSize(data[lastIndex]);
-				}
-			}
-		}
-		anchor = RE2::ANCHOR_START;
-	}
+	RE2::Anchor anchor = re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED;
 
-	if (lastIndex) {
-		result = string(data, lastIndex);
-	}
+	// a replacement is usually about the size of its input
+	result.reserve(size);
+	result.append(data, lastIndex);
 
 	bool noMatch = true;
-	while (lastIndex <= size && re2->regexp.Match(str, lastIndex, size, anchor, &groups[0], groups.size())) {
+	while (lastIndex <= size && re2->match(str, lastIndex, size, anchor, &groups[0], groups.size())) {
 		noMatch = false;
-		if (!re2->global && re2->sticky) {
-			re2->lastIndex += replacee.isBuffer ? match.data() - data + match.size() - lastIndex :
-				getUtf16Length(data + lastIndex, match.data() + match.size());
-		}
+		matchEnd = match.data() - data + match.size();
 		if (match.size()) {
 			if (match.data() == data || match.data() - data > lastIndex) {
-				result += string(data + lastIndex, match.data() - data - lastIndex);
+				result.append(data + lastIndex, match.data() - data - lastIndex);
 			}
-			result += replace(replacer, replacer_size, groups, str, namedGroups);
+			replacer.apply(&groups[0], str, result);
 			lastIndex = match.data() - data + match.size();
 		} else {
-			result += replace(replacer, replacer_size, groups, str, namedGroups);
+			replacer.apply(&groups[0], str, result);
 			size_t sym_size = getUtf8CharSize(data[lastIndex]);
 			if (lastIndex < size) {
-				result.append(data + lastIndex, sym_size);
+				result.append(data + lastIndex, min(sym_size, size - lastIndex));
 			}
 			lastIndex += sym_size;
 		}
-		if (!re2->global) {
+		if (!re2->global || result.failed) {
 			break;
 		}
 	}
 	if (lastIndex < size) {
-		result += string(data + lastIndex, size - lastIndex);
+		result.append(data + lastIndex, size - lastIndex);
 	}
 
+	return !noMatch;
+}
+
+
+static void replace(WrappedRE2* re2, const StrVal& replacee, const char* replacer, size_t replacer_size, OutputBuffer& result) {
+	size_t lastIndex = 0, matchEnd = 0;
+	if (re2->sticky && !re2->global) {
+		lastIndex = replacee.getUtf8Offset(re2->lastIndex);
+	}
+
+	bool matched = replaceWithString(re2, replacee, lastIndex,
+		*re2->getReplacementTemplate(replacer, replacer_size), result, matchEnd);
+
 	if (re2->global) {
 		re2->lastIndex = 0;
 	} else if (re2->sticky) {
-		if (noMatch) {
-			re2->lastIndex = 0;
-		}
+		re2->lastIndex = matched ? replacee.getUtf16Offset(matchEnd) : 0;
 	}
-
-	return Nan::Just(result);
 }
 
 
-inline Nan::Maybe<string> replace(const Nan::Callback* replacer, const vector<StringPiece>& groups, const StringPiece& str, const Local<Value>& input, bool useBuffers, const map<string, int>& namedGroups) {
+inline bool replace(const Nan::Callback* replacer, const vector<StringPiece>& groups, const StrVal& str, const Local<Value>& input, bool useBuffers, const map<string, int>& namedGroups, OutputBuffer& output) {
 	vector< Local<Value> >	argv;
 
 	if (useBuffers) {
@@ -268,13 +264,13 @@ inline Nan::Maybe<string> replace(const Nan::Callback* replacer, const vector<St
 			const StringPiece& item = groups[i];
 			argv.push_back(Nan::CopyBuffer(item.data(), item.size()).ToLocalChecked());
 		}
-		argv.push_back(Nan::New(static_cast<int>(groups[0].data() - str.data())));
+		argv.push_back(Nan::New(static_cast<int>(groups[0].data() - str.data)));
 	} else {
 		for (size_t i = 0, n = groups.size(); i < n; ++i) {
 			const StringPiece& item = groups[i];
 			argv.push_back(Nan::New(item.data(), item.size()).ToLocalChecked());
 		}
-		argv.push_back(Nan::New(static_cast<int>(getUtf16Length(str.data(), groups[0].data()))));
+		argv.push_back(Nan::New(static_cast<int>(str.getUtf16Offset(groups[0].data() - str.data))));
 	}
 	argv.push_back(input);
 
@@ -292,77 +288,70 @@ inline Nan::Maybe<string> replace(const Nan::Callback* replacer, const vector<St
 	MaybeLocal<Value> maybeResult(Nan::Call(replacer->GetFunction(), v8::Isolate::GetCurrent()->GetCurrentContext()->Global(), static_cast<int>(argv.size()), &argv[0]));
 
 	if (maybeResult.IsEmpty()) {
-		return Nan::Nothing<string>();
+		return false;
 	}
 
 	Local<Value> result = maybeResult.ToLocalChecked();
 
 	if (node::Buffer::HasInstance(result)) {
-		return Nan::Just(string(node::Buffer::Data(result), node::Buffer::Length(result)));
+		output.append(node::Buffer::Data(result), node::Buffer::Length(result));
+		return true;
 	}
 
-	Nan::Utf8String val(result->ToString());
-	return Nan::Just(string(*val, val.length()));
+	MaybeLocal<String> maybeString(Nan::To<String>(result));
+	if (maybeString.IsEmpty()) {
+		return false;
+	}
+	Nan::Utf8String val(maybeString.ToLocalChecked());
+	output.append(*val, val.length());
+	return true;
 }
 
 
-static Nan::Maybe<string> replace(WrappedRE2* re2, const StrVal& replacee, const Nan::Callback* replacer, const Local<Value>& input, bool useBuffers) {
+static bool replace(WrappedRE2* re2, const StrVal& replacee, const Nan::Callback* replacer, const Local<Value>& input, bool useBuffers, OutputBuffer& result) {
 	const StringPiece str(replacee);
 	const char* data = str.data();
 	size_t      size = str.size();
 
-	vector<StringPiece> groups(re2->regexp.NumberOfCapturingGroups() + 1);
+	vector<StringPiece> groups(re2->regexp->NumberOfCapturingGroups() + 1);
 	const StringPiece& match = groups[0];
 
 	size_t lastIndex = 0;
-	string result;
 	RE2::Anchor anchor = RE2::UNANCHORED;
 
 	if (re2->sticky) {
 		if (!re2->global) {
-			if (replacee.isBuffer) {
-				lastIndex = re2->lastIndex;
-			} else {
-				for (size_t n = re2->lastIndex; n; --n) {
-					lastIndex += getUtf8CharSize(data[lastIndex]);
-				}
-			}
+			lastIndex = replacee.getUtf8Offset(re2->lastIndex);
 		}
 		anchor = RE2::ANCHOR_START;
 	}
 
-	if (lastIndex) {
-		result = string(data, lastIndex);
-	}
+	result.reserve(size);
+	result.append(data, lastIndex);
 
-	const map<string, int>& namedGroups = re2->regexp.NamedCapturingGroups();
+	const map<string, int>& namedGroups = re2->regexp->NamedCapturingGroups();
 
 	bool noMatch = true;
-	while (lastIndex <= size && re2->regexp.Match(str, lastIndex, size, anchor, &groups[0], groups.size())) {
+	while (lastIndex <= size && re2->match(str, lastIndex, size, anchor, &groups[0], groups.size())) {
 		noMatch = false;
 		if (!re2->global && re2->sticky) {
-			re2->lastIndex += replacee.isBuffer ? match.data() - data + match.size() - lastIndex :
-				getUtf16Length(data + lastIndex, match.data() + match.size());
+			re2->lastIndex = replacee.getUtf16Offset(match.data() - data + match.size());
 		}
 		if (match.size()) {
 			if (match.data() == data || match.data() - data > lastIndex) {
-				result += string(data + lastIndex, match.data() - data - lastIndex);
+				result.append(data + lastIndex, match.data() - data - lastIndex);
 			}
-			const Nan::Maybe<string> part(replace(replacer, groups, str, input, useBuffers, namedGroups));
-			if (part.IsNothing()) {
-				return part;
+			if (!replace(replacer, groups, replacee, input, useBuffers, namedGroups, result)) {
+				return false;
 			}
-			result += part.FromJust();
 			lastIndex = match.data() - data + match.size();
 		} else {
-			const Nan::Maybe<string> part(replace(replacer, groups, str, input, useBuffers, namedGroups));
-			if (part.IsNothing()) {
-				return part;
+			if (!replace(replacer, groups, replacee, input, useBuffers, namedGroups, result)) {
+				return false;
 			}
-			result += part.FromJust();
 			size_t sym_size = getUtf8CharSize(data[lastIndex]);
 			if (lastIndex < size) {
-				result.append(data + lastIndex, sym_size);
+				result.append(data + lastIndex, min(sym_size, size - lastIndex));
 			}
 			lastIndex += sym_size;
 		}
@@ -371,7 +360,7 @@ static Nan::Maybe<string> replace(WrappedRE2* re2, const StrVal& replacee, const
 		}
 	}
 	if (lastIndex < size) {
-		result += string(data + lastIndex, size - lastIndex);
+		result.append(data + lastIndex, size - lastIndex);
 	}
 
 	if (re2->global) {
@@ -382,20 +371,130 @@ static Nan::Maybe<string> replace(WrappedRE2* re2, const StrVal& replacee, const
 		}
 	}
 
-	return Nan::Just(result);
+	return true;
+}
+
+
+// batched replacer: all matches are found first, then the function is called once with an Int32Array
+// of [start, end] pairs (for the whole match, and every group) per match, and returns an array of replacements
+
+static bool replaceBatch(WrappedRE2* re2, const StrVal& replacee, const Nan::Callback* replacer, const Local<Value>& input, bool useBuffers, OutputBuffer& result) {
+	const StringPiece str(replacee);
+	const char* data = str.data();
+	size_t      size = str.size();
+
+	size_t stride = re2->regexp->NumberOfCapturingGroups() + 1;
+	vector<StringPiece> matches, groups(stride);
+	const StringPiece& match = groups[0];
+
+	size_t lastIndex = 0;
+	RE2::Anchor anchor = RE2::UNANCHORED;
+
+	if (re2->sticky) {
+		if (!re2->global) {
+			lastIndex = replacee.getUtf8Offset(re2->lastIndex);
+		}
+		anchor = RE2::ANCHOR_START;
+	}
+
+	size_t startIndex = lastIndex;
+
+	// actual work: collect all matches
+
+	while (lastIndex <= size && re2->match(str, lastIndex, size, anchor, &groups[0], stride)) {
+		matches.insert(matches.end(), groups.begin(), groups.end());
+		lastIndex = match.data() - data + match.size();
+		if (!match.size()) {
+			lastIndex += lastIndex < size ? getUtf8CharSize(data[lastIndex]) : 1;
+		}
+		if (!re2->global) {
+			break;
+		}
+	}
+
+	size_t count = matches.size() / stride;
+
+	if (re2->global) {
+		re2->lastIndex = 0;
+	} else if (re2->sticky) {
+		re2->lastIndex = count ? replacee.getUtf16Offset(matches[0].data() - data + matches[0].size()) : 0;
+	}
+
+	if (!count) {
+		result.append(data, size);
+		return true;
+	}
+
+	// call the replacer once
+
+	Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), matches.size() * 2 * sizeof(int32_t));
+	int32_t* spans = static_cast<int32_t*>(getArrayBufferData(buffer));
+	for (size_t i = 0, n = matches.size(); i < n; ++i) {
+		const StringPiece& item = matches[i];
+		if (item.data() == NULL) {
+			spans[2 * i] = spans[2 * i + 1] = -1;
+			continue;
+		}
+		size_t start = item.data() - data, end = start + item.size();
+		spans[2 * i]     = static_cast<int32_t>(useBuffers ? start : replacee.getUtf16Offset(start));
+		spans[2 * i + 1] = static_cast<int32_t>(useBuffers ? end : replacee.getUtf16Offset(end));
+	}
+
+	Local<Value> argv[] = {v8::Int32Array::New(buffer, 0, matches.size() * 2), input, Nan::New(static_cast<int>(stride))};
+	MaybeLocal<Value> maybeReplacements(Nan::Call(replacer->GetFunction(), v8::Isolate::GetCurrent()->GetCurrentContext()->Global(), 3, argv));
+	if (maybeReplacements.IsEmpty()) {
+		return false;
+	}
+
+	Local<Value> replacements = maybeReplacements.ToLocalChecked();
+	if (!replacements->IsArray() || replacements.As<Array>()->Length() < count) {
+		Nan::ThrowTypeError("A batched replacer should return an array of replacements: one for each match.");
+		return false;
+	}
+
+	// form a result
+
+	Local<Array> parts = replacements.As<Array>();
+	result.reserve(size);
+	result.append(data, startIndex);
+	size_t cursor = startIndex;
+	for (size_t i = 0; i < count; ++i) {
+		const StringPiece& item = matches[i * stride];
+		result.append(data + cursor, item.data() - data - cursor);
+		cursor = item.data() - data + item.size();
+
+		MaybeLocal<Value> maybePart(Nan::Get(parts, i));
+		if (maybePart.IsEmpty()) {
+			return false;
+		}
+		Local<Value> part = maybePart.ToLocalChecked();
+		if (node::Buffer::HasInstance(part)) {
+			result.append(node::Buffer::Data(part), node::Buffer::Length(part));
+			continue;
+		}
+		MaybeLocal<String> maybeString(Nan::To<String>(part));
+		if (maybeString.IsEmpty()) {
+			return false;
+		}
+		Nan::Utf8String val(maybeString.ToLocalChecked());
+		result.append(*val, val.length());
+	}
+	result.append(data + cursor, size - cursor);
+
+	return true;
 }
 
 
-static bool requiresBuffers(const Local<Function>& f) {
-	Local<Value> flag(Nan::Get(f, Nan::New("useBuffers").ToLocalChecked()).ToLocalChecked());
+static bool getFlag(const Local<Function>& f, const char* name) {
+	Local<Value> flag(Nan::Get(f, Nan::New(name).ToLocalChecked()).ToLocalChecked());
 	if (flag->IsUndefined() || flag->IsNull() || flag->IsFalse()) {
 		return false;
 	}
 	if (flag->IsNumber()){
-		return flag->NumberValue() != 0;
+		return flag.As<v8::Number>()->Value() != 0;
 	}
 	if (flag->IsString()){
-		return flag->ToString()->Length() > 0;
+		return flag.As<String>()->Length() > 0;
 	}
 	return true;
 }
@@ -414,31 +513,29 @@ NAN_METHOD(WrappedRE2::Replace) {
 		return;
 	}
 
-	string result;
+	OutputBuffer result;
 
 	if (info[1]->IsFunction()) {
 		Local<Function> fun(info[1].As<Function>());
 		const unique_ptr<const Nan::Callback> cb(new Nan::Callback(fun));
-		const Nan::Maybe<string> replaced(replace(re2, replacee, cb.get(), info[0], requiresBuffers(fun)));
-		if (replaced.IsNothing()) {
+		bool done = getFlag(fun, "useBatch") ?
+			replaceBatch(re2, replacee, cb.get(), info[0], getFlag(fun, "useBuffers"), result) :
+			replace(re2, replacee, cb.get(), info[0], getFlag(fun, "useBuffers"), result);
+		if (!done) {
 			return;
 		}
-		result = replaced.FromJust();
 	} else {
 		StrVal replacer(info[1]);
 		if (!replacer.data) {
 			return;
 		}
-		const Nan::Maybe<string> replaced(replace(re2, replacee, replacer.data, replacer.size));
-		if (replaced.IsNothing()) {
-			return;
-		}
-		result = replaced.FromJust();
+		replace(re2, replacee, replacer.data, replacer.size, result);
 	}
 
-	if (replacee.isBuffer) {
-		info.GetReturnValue().Set(Nan::CopyBuffer(result.data(), result.size()).ToLocalChecked());
-		return;
+	if (result.failed) {
+		result.release();
+		return Nan::ThrowRangeError("Out of memory: the result of replace() is too large.");
 	}
-	info.GetReturnValue().Set(Nan::New(result).ToLocalChecked());
+
+	info.GetReturnValue().Set(result.toValue(replacee.isBuffer));
 }
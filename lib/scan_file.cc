@@ -0,0 +1,319 @@
+#include "./wrapped_re2.h"
+#include "./util.h"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+using std::string;
+using std::vector;
+
+using v8::ArrayBuffer;
+using v8::Float64Array;
+using v8::Isolate;
+using v8::Local;
+using v8::Object;
+using v8::String;
+using v8::Value;
+
+
+// A read-only memory mapping of a whole file: matching runs directly over mapped pages,
+// so a file is never copied into the V8 heap, and the page cache does the work.
+
+class MappedFile {
+	public:
+		MappedFile() : data(NULL), size(0) {
+#ifdef _WIN32
+			file = mapping = NULL;
+#endif
+		}
+
+		~MappedFile() { close(); }
+
+		// returns false, and sets an error message, if a file cannot be mapped
+		bool open(const string& path, string& error);
+		void close();
+
+		const char* data;
+		size_t      size;
+
+	private:
+#ifdef _WIN32
+		HANDLE file, mapping;
+#endif
+};
+
+
+#ifdef _WIN32
+
+bool MappedFile::open(const string& path, string& error) {
+	int n = MultiByteToWideChar(CP_UTF8, 0, path.data(), static_cast<int>(path.size()), NULL, 0);
+	std::wstring widePath(n, L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, path.data(), static_cast<int>(path.size()), &widePath[0], n);
+
+	file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		file  = NULL;
+		error = "Cannot open a file: " + path;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		error = "Cannot get a file size: " + path;
+		return false;
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+	if (!size) {
+		data = "";
+		return true;
+	}
+	mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping) {
+		error = "Cannot map a file: " + path;
+		return false;
+	}
+	data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!data) {
+		error = "Cannot map a file: " + path;
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close() {
+	if (data && size) {
+		UnmapViewOfFile(data);
+	}
+	if (mapping) {
+		CloseHandle(mapping);
+	}
+	if (file) {
+		CloseHandle(file);
+	}
+	data = NULL;
+	size = 0;
+	file = mapping = NULL;
+}
+
+#else
+
+bool MappedFile::open(const string& path, string& error) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		error = "Cannot open a file: " + path + ": " + strerror(errno);
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) < 0) {
+		error = "Cannot get a file size: " + path + ": " + strerror(errno);
+		::close(fd);
+		return false;
+	}
+	size = static_cast<size_t>(info.st_size);
+	if (!size) {
+		::close(fd);
+		data = "";
+		return true;
+	}
+	void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // a mapping keeps a file open
+	if (mapped == MAP_FAILED) {
+		error = "Cannot map a file: " + path + ": " + strerror(errno);
+		size  = 0;
+		return false;
+	}
+	madvise(mapped, size, MADV_SEQUENTIAL);
+	data = static_cast<const char*>(mapped);
+	return true;
+}
+
+void MappedFile::close() {
+	if (data && size) {
+		munmap(const_cast<char*>(data), size);
+	}
+	data = NULL;
+	size = 0;
+}
+
+#endif
+
+
+// scanFile() options: {lines, maxMatches}
+
+struct ScanOptions {
+	bool   lines;
+	double maxMatches;
+
+	ScanOptions() : lines(false), maxMatches(-1) {}
+};
+
+// returns false, if an exception was thrown
+static bool getScanOptions(const Local<Value>& arg, ScanOptions& options) {
+	if (!arg->IsObject()) {
+		return true;
+	}
+	Local<Object> object(arg.As<Object>());
+	options.lines = Nan::To<bool>(Nan::Get(object, Nan::New("lines").ToLocalChecked()).ToLocalChecked()).FromJust();
+	Local<Value> maxMatches(Nan::Get(object, Nan::New("maxMatches").ToLocalChecked()).ToLocalChecked());
+	if (!maxMatches->IsUndefined()) {
+		if (!maxMatches->IsNumber() || !(maxMatches.As<v8::Number>()->Value() >= 0)) {
+			Nan::ThrowRangeError("maxMatches should be a non-negative number.");
+			return false;
+		}
+		options.maxMatches = maxMatches.As<v8::Number>()->Value();
+	}
+	return true;
+}
+
+// collects [offset, length] pairs of all matches, or 1-based numbers of matched lines (each line is reported once)
+static void scan(WrappedRE2* re2, const char* data, size_t size, const ScanOptions& options, vector<double>& result) {
+	StringPiece text(data, size), match;
+	size_t pos = 0, lineStart = 0, line = 1, lastLine = 0, count = 0;
+
+	while (pos <= size && (options.maxMatches < 0 || count < options.maxMatches) &&
+			re2->match(text, pos, size, RE2::UNANCHORED, &match, 1)) {
+		size_t from = match.data() - data, to = from + match.size();
+		if (options.lines) {
+			for (const char* p = data + lineStart, *end = data + from; (p = static_cast<const char*>(memchr(p, '\n', end - p))); ++p) {
+				++line;
+			}
+			lineStart = from;
+			if (line != lastLine) {
+				result.push_back(line);
+				lastLine = line;
+				++count;
+			}
+		} else {
+			result.push_back(from);
+			result.push_back(match.size());
+			++count;
+		}
+		pos = match.size() ? to : to + (to < size ? getUtf8CharSize(data[to]) : 1);
+	}
+}
+
+static Local<Float64Array> toFloat64Array(const vector<double>& values) {
+	Local<ArrayBuffer> buffer = ArrayBuffer::New(Isolate::GetCurrent(), values.size() * sizeof(double));
+	if (!values.empty()) {
+		memcpy(getArrayBufferData(buffer), &values[0], values.size() * sizeof(double));
+	}
+	return Float64Array::New(buffer, 0, values.size());
+}
+
+// common argument handling: returns an RE2 object, or NULL, if an exception was thrown
+static WrappedRE2* getArguments(const Nan::FunctionCallbackInfo<Value>& info, string& path, ScanOptions& options) {
+	if (!info[0]->IsString()) {
+		Nan::ThrowTypeError("A file name was expected as the first argument.");
+		return NULL;
+	}
+	Nan::Utf8String name(info[0]);
+	path.assign(*name, name.length());
+
+	if (!info[1]->IsObject() || !WrappedRE2::HasInstance(info[1].As<Object>())) {
+		Nan::ThrowTypeError("An RE2 object was expected as the second argument.");
+		return NULL;
+	}
+
+	if (!getScanOptions(info[2], options)) {
+		return NULL;
+	}
+
+	return Nan::ObjectWrap::Unwrap<WrappedRE2>(info[1].As<Object>());
+}
+
+
+NAN_METHOD(WrappedRE2::ScanFile) {
+
+	// unpack arguments
+
+	string path;
+	ScanOptions options;
+	WrappedRE2* re2 = getArguments(info, path, options);
+	if (!re2) {
+		return;
+	}
+
+	// actual work
+
+	MappedFile file;
+	string error;
+	if (!file.open(path, error)) {
+		return Nan::ThrowError(error.c_str());
+	}
+
+	vector<double> result;
+	scan(re2, file.data, file.size, options, result);
+
+	// form a result
+
+	info.GetReturnValue().Set(toFloat64Array(result));
+}
+
+
+// the asynchronous version maps and scans a file on the thread pool
+
+class ScanFileWorker : public Nan::AsyncWorker {
+	public:
+		ScanFileWorker(Nan::Callback* callback, WrappedRE2* re2, const Local<Object>& self, const string& path, const ScanOptions& options) :
+				Nan::AsyncWorker(callback, "re2:scanFile"), re2(re2), path(path), options(options) {
+			SaveToPersistent("re2", self);
+			re2->hold();
+		}
+
+		~ScanFileWorker() { re2->release(); }
+
+		void Execute() {
+			MappedFile file;
+			string error;
+			if (!file.open(path, error)) {
+				SetErrorMessage(error.c_str());
+				return;
+			}
+			scan(re2, file.data, file.size, options, result);
+		}
+
+		void HandleOKCallback() {
+			Nan::HandleScope scope;
+			Local<Value> argv[] = {Nan::Null(), toFloat64Array(result)};
+			callback->Call(2, argv, async_resource);
+		}
+
+	private:
+		WrappedRE2*    re2;
+		string         path;
+		ScanOptions    options;
+		vector<double> result;
+};
+
+
+NAN_METHOD(WrappedRE2::ScanFileAsync) {
+
+	// unpack arguments
+
+	string path;
+	ScanOptions options;
+	WrappedRE2* re2 = getArguments(info, path, options);
+	if (!re2) {
+		return;
+	}
+
+	if (!info[3]->IsFunction()) {
+		return Nan::ThrowTypeError("A callback function was expected.");
+	}
+
+	// actual work
+
+	Nan::Callback* callback = new Nan::Callback(info[3].As<Function>());
+	Nan::AsyncQueueWorker(new ScanFileWorker(callback, re2, info[1].As<Object>(), path, options));
+}
@@ -0,0 +1,220 @@
+#include "./wrapped_re2.h"
+#include "./wrapped_re2_scanner.h"
+#include "./util.h"
+
+#include <node_buffer.h>
+
+
+using v8::Array;
+using v8::Local;
+using v8::Object;
+using v8::Value;
+
+
+NAN_METHOD(WrappedRE2::CreateScanner) {
+
+	// unpack arguments
+
+	if (!WrappedRE2::HasInstance(info.This())) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+
+	size_t maxMatchLength = WrappedRE2Scanner::defaultMaxMatchLength;
+
+	if (info[0]->IsObject()) {
+		Local<Value> value(Nan::Get(info[0].As<Object>(), Nan::New("maxMatchLength").ToLocalChecked()).ToLocalChecked());
+		if (!value->IsUndefined()) {
+			double n = value->IsNumber() ? value.As<v8::Number>()->Value() : 0;
+			if (!(n >= 1 && n <= 0x7FFFFFFF)) {
+				return Nan::ThrowRangeError("maxMatchLength should be a positive number of bytes.");
+			}
+			maxMatchLength = static_cast<size_t>(n);
+		}
+	}
+
+	// form a result
+
+	Nan::MaybeLocal<Object> scanner = WrappedRE2Scanner::Create(info.This(), maxMatchLength);
+	if (!scanner.IsEmpty()) {
+		info.GetReturnValue().Set(scanner.ToLocalChecked());
+	}
+}
+
+
+Nan::MaybeLocal<Object> WrappedRE2Scanner::Create(const Local<Object>& regexp, size_t maxMatchLength) {
+	if (!WrappedRE2::HasInstance(regexp)) {
+		Nan::ThrowTypeError("RE2 object was expected.");
+		return Nan::MaybeLocal<Object>();
+	}
+
+	Nan::MaybeLocal<Object> maybeScanner = Nan::NewInstance(Nan::New<Function>(constructor));
+	if (maybeScanner.IsEmpty()) {
+		return maybeScanner;
+	}
+
+	Local<Object> scanner = maybeScanner.ToLocalChecked();
+	WrappedRE2Scanner* self = Nan::ObjectWrap::Unwrap<WrappedRE2Scanner>(scanner);
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(regexp);
+	self->re2 = re2;
+	self->regexp.Reset(regexp);
+	self->maxMatchLength = maxMatchLength;
+	self->groups.resize(re2->regexp->NumberOfCapturingGroups() + 1);
+
+	return scanner;
+}
+
+
+// A match, which starts before size - maxMatchLength - 4, ends before the last 4 bytes of the data,
+// so it cannot be changed by the following chunks: 4 bytes are enough to see a whole UTF-8 character
+// after it for assertions like \b. Everything before such a match was searched too, so it is final as well.
+// A match, which is longer than maxMatchLength, can be reported incorrectly.
+
+void WrappedRE2Scanner::scan(const char* chunk, size_t chunkSize, bool final, Local<Array> results) {
+	data.insert(data.end(), chunk, chunk + chunkSize);
+
+	static char empty = 0;
+
+	StrVal str;
+	str.data     = data.empty() ? &empty : &data[0];
+	str.size     = str.length = data.size();
+	str.isBuffer = true;
+
+	size_t size = data.size(), lookahead = maxMatchLength + 4,
+		limit = final ? size + 1 : (size > lookahead ? size - lookahead : 0);
+
+	uint32_t count = results->Length();
+	while (pos < limit) {
+		if (!re2->match(str, pos, size, RE2::UNANCHORED, &groups[0], groups.size())) {
+			pos = limit;
+			break;
+		}
+		size_t from = groups[0].data() - str.data, to = from + groups[0].size();
+		if (from >= limit) {
+			pos = limit;
+			break;
+		}
+
+		Local<Array> result = formExecResult(re2, str, &groups[0], groups.size(), Nan::Undefined());
+		Nan::Set(result, getKey(KEY_INDEX), Nan::New<v8::Number>(static_cast<double>(base + from)));
+		Nan::Set(results, count++, result);
+
+		// advance past the match, empty matches advance by one character
+		pos = groups[0].size() ? to : to + (to < size ? getUtf8CharSize(str.data[to]) : 1);
+	}
+
+	if (final) {
+		return;
+	}
+
+	// keep one byte before the scanning position as a context for ^ and \b
+	size_t keep = pos ? pos - 1 : 0;
+	data.erase(data.begin(), data.begin() + keep);
+	base += keep;
+	pos  -= keep;
+}
+
+
+NAN_METHOD(WrappedRE2Scanner::New) {
+
+	if (!info.IsConstructCall()) {
+		return Nan::ThrowTypeError("Use RE2.prototype.createScanner() to create a scanner.");
+	}
+
+	WrappedRE2Scanner* scanner = new WrappedRE2Scanner();
+	scanner->Wrap(info.This());
+	info.GetReturnValue().Set(info.This());
+}
+
+
+NAN_METHOD(WrappedRE2Scanner::Write) {
+
+	// unpack arguments
+
+	if (!HasInstance(info.This())) {
+		return Nan::ThrowTypeError("RE2 scanner was expected.");
+	}
+
+	WrappedRE2Scanner* self = Nan::ObjectWrap::Unwrap<WrappedRE2Scanner>(info.This());
+	if (!self) {
+		return Nan::ThrowTypeError("RE2 scanner was expected.");
+	}
+
+	if (self->done || !self->re2) {
+		return Nan::ThrowError("write() was called after end().");
+	}
+
+	if (!node::Buffer::HasInstance(info[0])) {
+		return Nan::ThrowTypeError("A buffer was expected.");
+	}
+
+	// actual work
+
+	Local<Array> results = Nan::New<Array>();
+	self->scan(node::Buffer::Data(info[0]), node::Buffer::Length(info[0]), false, results);
+
+	// form a result
+
+	info.GetReturnValue().Set(results);
+}
+
+
+NAN_METHOD(WrappedRE2Scanner::End) {
+
+	// unpack arguments
+
+	if (!HasInstance(info.This())) {
+		return Nan::ThrowTypeError("RE2 scanner was expected.");
+	}
+
+	WrappedRE2Scanner* self = Nan::ObjectWrap::Unwrap<WrappedRE2Scanner>(info.This());
+	if (!self) {
+		return Nan::ThrowTypeError("RE2 scanner was expected.");
+	}
+
+	if (self->done || !self->re2) {
+		return Nan::ThrowError("end() was called twice.");
+	}
+
+	const char* chunk = NULL;
+	size_t size = 0;
+	if (node::Buffer::HasInstance(info[0])) {
+		chunk = node::Buffer::Data(info[0]);
+		size  = node::Buffer::Length(info[0]);
+	} else if (!info[0]->IsUndefined()) {
+		return Nan::ThrowTypeError("A buffer was expected.");
+	}
+
+	// actual work
+
+	Local<Array> results = Nan::New<Array>();
+	self->scan(chunk, size, true, results);
+
+	// release the data and the regular expression as soon as possible
+	self->base += self->data.size();
+	std::vector<char>().swap(self->data);
+	self->pos  = 0;
+	self->done = true;
+	self->regexp.Reset();
+	self->re2 = NULL;
+
+	// form a result
+
+	info.GetReturnValue().Set(results);
+}
+
+
+NAN_GETTER(WrappedRE2Scanner::GetOffset) {
+	if (!HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2Scanner* self = Nan::ObjectWrap::Unwrap<WrappedRE2Scanner>(info.This());
+	if (!self) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+	// the number of bytes written so far
+	info.GetReturnValue().Set(static_cast<double>(self->base + self->data.size()));
+}
@@ -15,20 +15,22 @@ NAN_METHOD(WrappedRE2::Search) {
 		return;
 	}
 
-	StrVal a(info[0]);
-	if (!a.data) {
-		return;
-	}
+	int index = -1;
+	{
+		// a subject can be borrowed from the V8 heap, so it is released before a result is set
+		StrVal a(info[0], StrVal::BORROW_FLAT);
+		if (!a.data) {
+			return;
+		}
 
-	// actual work
+		// actual work
 
-	StringPiece match;
+		StringPiece match;
 
-	if (re2->regexp.Match(a, 0, a.size, re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED, &match, 1)) {
-		info.GetReturnValue().Set(static_cast<int>(a.isBuffer ? match.data() - a.data :
-			getUtf16Length(a.data, match.data())));
-		return;
+		if (re2->match(a, 0, a.size, re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED, &match, 1)) {
+			index = static_cast<int>(a.getUtf16Offset(match.data() - a.data));
+		}
 	}
 
-	info.GetReturnValue().Set(-1);
+	info.GetReturnValue().Set(index);
 }
@@ -0,0 +1,366 @@
+#include "./wrapped_re2_set.h"
+#include "./util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <node_buffer.h>
+
+
+using std::sort;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+using v8::Array;
+using v8::Local;
+using v8::RegExp;
+using v8::String;
+using v8::Value;
+
+
+bool parseFlags(const Local<Value>& arg, bool& ignoreCase, bool& multiline) {
+	vector<char> buffer;
+
+	char*  data = NULL;
+	size_t size = 0;
+
+	if (arg->IsString()) {
+		Local<String> t(arg.As<String>());
+		buffer.resize(utf8Length(t) + 1);
+		writeUtf8Chars(t, &buffer[0]);
+		size = buffer.size() - 1;
+		data = &buffer[0];
+	} else if (node::Buffer::HasInstance(arg)) {
+		size = node::Buffer::Length(arg);
+		data = node::Buffer::Data(arg);
+	} else {
+		return false;
+	}
+
+	for (size_t i = 0; i < size; ++i) {
+		switch (data[i]) {
+			case 'i':
+				ignoreCase = true;
+				break;
+			case 'm':
+				multiline = true;
+				break;
+		}
+	}
+
+	return true;
+}
+
+
+static bool parseAnchor(const Local<Value>& arg, RE2::Anchor& anchor) {
+	Local<Value> value(Nan::Get(arg.As<Object>(), Nan::New("anchor").ToLocalChecked()).ToLocalChecked());
+	if (value->IsUndefined()) {
+		return true;
+	}
+	if (value->IsString()) {
+		Nan::Utf8String name(value);
+		if (!strcmp(*name, "unanchored")) {
+			anchor = RE2::UNANCHORED;
+			return true;
+		}
+		if (!strcmp(*name, "start")) {
+			anchor = RE2::ANCHOR_START;
+			return true;
+		}
+		if (!strcmp(*name, "both")) {
+			anchor = RE2::ANCHOR_BOTH;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool getPattern(const Local<Value>& arg, vector<char>& buffer, string& source, StringPiece& pattern) {
+	char*  data = NULL;
+	size_t size = 0;
+
+	if (node::Buffer::HasInstance(arg)) {
+		size = node::Buffer::Length(arg);
+		data = node::Buffer::Data(arg);
+	} else if (arg->IsRegExp()) {
+		const RegExp* re = RegExp::Cast(*arg);
+		Local<String> t(re->GetSource());
+		buffer.resize(utf8Length(t) + 1);
+		writeUtf8Chars(t, &buffer[0]);
+		size = buffer.size() - 1;
+		data = &buffer[0];
+	} else if (arg->IsObject() && !arg->IsString()) {
+		WrappedRE2* re2 = NULL;
+		Local<Object> object(arg.As<Object>());
+		if (!object.IsEmpty() && object->InternalFieldCount() > 0 && WrappedRE2::HasInstance(object)) {
+			re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(object);
+		}
+		if (!re2) {
+			return false;
+		}
+		const string& internal = re2->regexp->pattern();
+		buffer.assign(internal.begin(), internal.end());
+		buffer.push_back('\0');
+		source = re2->source;
+		pattern = StringPiece(&buffer[0], internal.size());
+		return true;
+	} else if (arg->IsString()) {
+		Local<String> t(arg.As<String>());
+		buffer.resize(utf8Length(t) + 1);
+		writeUtf8Chars(t, &buffer[0]);
+		size = buffer.size() - 1;
+		data = &buffer[0];
+	} else {
+		return false;
+	}
+
+	source = escapeRegExp(data, size);
+
+	if (translateRegExp(data, size, buffer)) {
+		size = buffer.size() - 1;
+		data = &buffer[0];
+	}
+
+	pattern = StringPiece(data, size);
+	return true;
+}
+
+
+NAN_METHOD(WrappedRE2Set::New) {
+
+	if (!info.IsConstructCall()) {
+		// call a constructor and return the result
+
+		vector< Local<Value> > parameters(info.Length());
+		for (size_t i = 0, n = info.Length(); i < n; ++i) {
+			parameters[i] = info[i];
+		}
+		auto newObject = Nan::NewInstance(Nan::New<Function>(constructor), parameters.size(), &parameters[0]);
+		if (!newObject.IsEmpty()) {
+			info.GetReturnValue().Set(newObject.ToLocalChecked());
+		}
+		return;
+	}
+
+	// process arguments
+
+	if (!info[0]->IsArray()) {
+		return Nan::ThrowTypeError("Expected an array of patterns as the 1st argument.");
+	}
+
+	bool ignoreCase = false;
+	bool multiline = false;
+	RE2::Anchor anchor = RE2::UNANCHORED;
+
+	int optionsArg = 1;
+	if (info.Length() > 1 && parseFlags(info[1], ignoreCase, multiline)) {
+		optionsArg = 2;
+	}
+	if (info.Length() > optionsArg && info[optionsArg]->IsObject() && !parseAnchor(info[optionsArg], anchor)) {
+		return Nan::ThrowTypeError("Expected \"unanchored\", \"start\", or \"both\" as an anchor option.");
+	}
+
+	// create and fill a set
+
+	RE2::Options options;
+	options.set_case_sensitive(!ignoreCase);
+	options.set_one_line(!multiline);
+	options.set_log_errors(false); // inappropriate when embedding
+
+	unique_ptr<WrappedRE2Set> re2set(new WrappedRE2Set(options, anchor, ignoreCase, multiline));
+
+	Local<Array> patterns(info[0].As<Array>());
+	vector<char> buffer;
+	string source, error;
+	StringPiece pattern;
+
+	for (uint32_t i = 0, n = patterns->Length(); i < n; ++i) {
+		Nan::MaybeLocal<Value> item(Nan::Get(patterns, i));
+		if (item.IsEmpty()) {
+			return;
+		}
+		if (!getPattern(item.ToLocalChecked(), buffer, source, pattern)) {
+			return Nan::ThrowTypeError("Expected string, Buffer, RegExp, or RE2 as a pattern.");
+		}
+		if (re2set->set.Add(pattern, &error) < 0) {
+			return Nan::ThrowSyntaxError(error.c_str());
+		}
+		re2set->sources.push_back(source);
+	}
+
+	if (!re2set->set.Compile()) {
+		return Nan::ThrowError("RE2.Set could not be compiled.");
+	}
+
+	re2set->Wrap(info.This());
+	re2set.release();
+
+	info.GetReturnValue().Set(info.This());
+}
+
+
+// RE2::Set::Match() fails instead of reporting no matches, when it cannot finish, e.g., when its DFA is out of memory
+
+static void throwMatchError(const RE2::Set::ErrorInfo& error) {
+	if (error.kind == RE2::Set::kOutOfMemory) {
+		Nan::ThrowError("Out of memory: RE2.Set could not finish matching.");
+	} else {
+		Nan::ThrowError("RE2.Set could not finish matching.");
+	}
+}
+
+
+NAN_METHOD(WrappedRE2Set::Match) {
+
+	Local<Array> result = Nan::New<Array>();
+
+	// unpack arguments
+
+	WrappedRE2Set* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2Set>(info.This());
+	if (!re2set) {
+		info.GetReturnValue().Set(result);
+		return;
+	}
+
+	vector<int> matches;
+	RE2::Set::ErrorInfo error;
+	error.kind = RE2::Set::kNoError;
+	{
+		// a subject can be borrowed from the V8 heap, so it is released before V8 is called
+		StrVal str(info[0], StrVal::BORROW_FLAT);
+		if (!str.data) {
+			return;
+		}
+
+		// actual work
+
+		if (!re2set->sources.empty()) {
+			re2set->set.Match(str, &matches, &error);
+		}
+	}
+	if (error.kind != RE2::Set::kNoError) {
+		return throwMatchError(error);
+	}
+	sort(matches.begin(), matches.end());
+
+	// form a result
+
+	for (size_t i = 0, n = matches.size(); i < n; ++i) {
+		Nan::Set(result, i, Nan::New(matches[i]));
+	}
+
+	info.GetReturnValue().Set(result);
+}
+
+
+NAN_METHOD(WrappedRE2Set::Test) {
+
+	// unpack arguments
+
+	WrappedRE2Set* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2Set>(info.This());
+	if (!re2set) {
+		info.GetReturnValue().Set(false);
+		return;
+	}
+
+	bool matched = false;
+	RE2::Set::ErrorInfo error;
+	error.kind = RE2::Set::kNoError;
+	{
+		// a subject can be borrowed from the V8 heap, so it is released before V8 is called
+		StrVal str(info[0], StrVal::BORROW_FLAT);
+		if (!str.data) {
+			return;
+		}
+
+		// actual work
+
+		if (!re2set->sources.empty()) {
+			matched = re2set->set.Match(str, NULL, &error);
+		}
+	}
+	if (!matched && error.kind != RE2::Set::kNoError) {
+		return throwMatchError(error);
+	}
+
+	info.GetReturnValue().Set(matched);
+}
+
+
+NAN_GETTER(WrappedRE2Set::GetSize) {
+	if (!WrappedRE2Set::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2Set* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2Set>(info.This());
+	info.GetReturnValue().Set(static_cast<int>(re2set->sources.size()));
+}
+
+
+NAN_GETTER(WrappedRE2Set::GetFlags) {
+	if (!WrappedRE2Set::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2Set* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2Set>(info.This());
+
+	string flags;
+	if (re2set->ignoreCase) {
+		flags = "i";
+	}
+	if (re2set->multiline) {
+		flags += "m";
+	}
+	flags += "u";
+
+	info.GetReturnValue().Set(Nan::New(flags).ToLocalChecked());
+}
+
+
+NAN_GETTER(WrappedRE2Set::GetAnchor) {
+	if (!WrappedRE2Set::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2Set* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2Set>(info.This());
+
+	const char* anchor;
+	switch (re2set->anchor) {
+		case RE2::ANCHOR_START:
+			anchor = "start";
+			break;
+		case RE2::ANCHOR_BOTH:
+			anchor = "both";
+			break;
+		default:
+			anchor = "unanchored";
+			break;
+	}
+
+	info.GetReturnValue().Set(Nan::New(anchor).ToLocalChecked());
+}
+
+
+NAN_GETTER(WrappedRE2Set::GetSources) {
+	if (!WrappedRE2Set::HasInstance(info.This())) {
+		info.GetReturnValue().SetUndefined();
+		return;
+	}
+
+	WrappedRE2Set* re2set = Nan::ObjectWrap::Unwrap<WrappedRE2Set>(info.This());
+
+	Local<Array> result = Nan::New<Array>();
+	for (size_t i = 0, n = re2set->sources.size(); i < n; ++i) {
+		Nan::Set(result, i, Nan::New(re2set->sources[i]).ToLocalChecked());
+	}
+
+	info.GetReturnValue().Set(result);
+}
@@ -0,0 +1,146 @@
+#include "./shared_registry.h"
+
+#include <algorithm>
+
+
+using std::lock_guard;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::unordered_map;
+using std::weak_ptr;
+
+using v8::Local;
+using v8::MaybeLocal;
+using v8::Object;
+using v8::String;
+using v8::Value;
+
+
+mutex                                          SharedRegistry::guard;
+unordered_map<uint64_t, weak_ptr<const RE2> >  SharedRegistry::entries;
+unordered_map<const RE2*, uint64_t>            SharedRegistry::ids;
+
+uint64_t SharedRegistry::nextId  = 1;
+size_t   SharedRegistry::sweepAt = 64;
+
+
+void SharedRegistry::sweep() {
+	for (auto i = entries.begin(); i != entries.end();) {
+		if (i->second.expired()) {
+			i = entries.erase(i);
+		} else {
+			++i;
+		}
+	}
+	for (auto i = ids.begin(); i != ids.end();) {
+		if (entries.find(i->second) == entries.end()) {
+			i = ids.erase(i);
+		} else {
+			++i;
+		}
+	}
+	// sweep again, when the registry doubles
+	sweepAt = std::max(static_cast<size_t>(64), 2 * entries.size());
+}
+
+
+uint64_t SharedRegistry::add(const shared_ptr<const RE2>& regexp) {
+	lock_guard<mutex> lock(guard);
+
+	// a program can be freed, and its address reused, so a found id should refer to the same live program
+	auto found = ids.find(regexp.get());
+	if (found != ids.end()) {
+		auto entry = entries.find(found->second);
+		if (entry != entries.end() && entry->second.lock() == regexp) {
+			return found->second;
+		}
+	}
+
+	if (entries.size() >= sweepAt) {
+		sweep();
+	}
+
+	uint64_t id = nextId++;
+	entries[id] = regexp;
+	ids[regexp.get()] = id;
+	return id;
+}
+
+
+shared_ptr<const RE2> SharedRegistry::find(uint64_t id) {
+	lock_guard<mutex> lock(guard);
+	auto found = entries.find(id);
+	return found != entries.end() ? found->second.lock() : shared_ptr<const RE2>();
+}
+
+
+// handles are plain objects: {sharedId, source, flags, pattern, options}, so they survive structured cloning
+
+static bool getString(const Local<Object>& object, const char* name, string& result) {
+	MaybeLocal<Value> t(Nan::Get(object, Nan::New(name).ToLocalChecked()));
+	if (t.IsEmpty() || !t.ToLocalChecked()->IsString()) {
+		return false;
+	}
+	Nan::Utf8String s(t.ToLocalChecked());
+	result.assign(*s, s.length());
+	return true;
+}
+
+bool unpackSharedHandle(const Local<Object>& object, SharedHandle& handle) {
+	MaybeLocal<Value> t(Nan::Get(object, Nan::New("sharedId").ToLocalChecked()));
+	if (t.IsEmpty() || !t.ToLocalChecked()->IsNumber()) {
+		return false;
+	}
+	double id = t.ToLocalChecked().As<v8::Number>()->Value();
+
+	string flags;
+	if (!getString(object, "source", handle.source) || !getString(object, "pattern", handle.pattern) || !getString(object, "flags", flags)) {
+		return false;
+	}
+	handle.global     = flags.find('g') != string::npos;
+	handle.ignoreCase = flags.find('i') != string::npos;
+	handle.multiline  = flags.find('m') != string::npos;
+	handle.sticky     = flags.find('y') != string::npos;
+
+	t = Nan::Get(object, Nan::New("options").ToLocalChecked());
+	handle.options = t.IsEmpty() ? Local<Value>(Nan::Undefined()) : t.ToLocalChecked();
+
+	handle.regexp = id >= 1 && id < 9e15 ? SharedRegistry::find(static_cast<uint64_t>(id)) : shared_ptr<const RE2>();
+	return true;
+}
+
+
+NAN_METHOD(WrappedRE2::Share) {
+
+	// unpack arguments
+
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+
+	// actual work
+
+	uint64_t id = SharedRegistry::add(re2->regexp);
+
+	// form a result
+
+	const RE2::Options& options = re2->regexp->options();
+	Local<Object> programOptions = Nan::New<Object>();
+	Nan::Set(programOptions, Nan::New("maxMem").ToLocalChecked(),       Nan::New<v8::Number>(static_cast<double>(options.max_mem())));
+	Nan::Set(programOptions, Nan::New("longestMatch").ToLocalChecked(), Nan::New(options.longest_match()));
+	Nan::Set(programOptions, Nan::New("literal").ToLocalChecked(),      Nan::New(options.literal()));
+	Nan::Set(programOptions, Nan::New("neverNL").ToLocalChecked(),      Nan::New(options.never_nl()));
+	Nan::Set(programOptions, Nan::New("dotNL").ToLocalChecked(),        Nan::New(options.dot_nl()));
+	Nan::Set(programOptions, Nan::New("posixSyntax").ToLocalChecked(),  Nan::New(options.posix_syntax()));
+
+	Local<Object> handle = Nan::New<Object>();
+	Nan::Set(handle, Nan::New("sharedId").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(id)));
+	Nan::Set(handle, Nan::New("source").ToLocalChecked(),   Nan::New(re2->source).ToLocalChecked());
+	Nan::Set(handle, Nan::New("flags").ToLocalChecked(),    Nan::New(re2->getFlags()).ToLocalChecked());
+	Nan::Set(handle, Nan::New("pattern").ToLocalChecked(),  Nan::New(re2->regexp->pattern()).ToLocalChecked());
+	Nan::Set(handle, Nan::New("options").ToLocalChecked(),  programOptions);
+
+	info.GetReturnValue().Set(handle);
+}
@@ -0,0 +1,52 @@
+#ifndef SHARED_REGISTRY_H_
+#define SHARED_REGISTRY_H_
+
+
+#include "./wrapped_re2.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+// A process-wide registry of compiled programs shared between isolates (worker threads).
+// re.share() registers a program, and returns a plain object, which can be posted to a worker,
+// where new RE2(handle) wraps the same program instead of compiling it again.
+// The registry does not own programs: an entry is valid, while any RE2 object uses its program.
+
+class SharedRegistry {
+
+	public:
+		// returns an id of a program: the same program always gets the same id
+		static uint64_t add(const std::shared_ptr<const RE2>& regexp);
+
+		// returns a registered program, or an empty pointer, if it was released
+		static std::shared_ptr<const RE2> find(uint64_t id);
+
+	private:
+		static void sweep(); // expects the mutex to be locked
+
+		static std::mutex guard;
+		static std::unordered_map<uint64_t, std::weak_ptr<const RE2> > entries;
+		static std::unordered_map<const RE2*, uint64_t> ids;
+		static uint64_t nextId;
+		static size_t   sweepAt;
+};
+
+
+// an unpacked handle created by share()
+
+struct SharedHandle {
+	std::shared_ptr<const RE2> regexp; // empty, if a program was released: then it is compiled from pattern and options
+	std::string                source, pattern;
+	bool                       global, ignoreCase, multiline, sticky;
+	Local<v8::Value>           options;
+};
+
+// returns false, if an object is not a handle created by share()
+bool unpackSharedHandle(const Local<Object>& object, SharedHandle& handle);
+
+
+#endif
@@ -37,7 +37,7 @@ NAN_METHOD(WrappedRE2::Split) {
 
 	size_t limit = numeric_limits<size_t>::max();
 	if (info.Length() > 1 && info[1]->IsNumber()) {
-		size_t lim = info[1]->NumberValue();
+		size_t lim = info[1].As<v8::Number>()->Value();
 		if (lim > 0) {
 			limit = lim;
 		}
@@ -45,11 +45,11 @@ NAN_METHOD(WrappedRE2::Split) {
 
 	// actual work
 
-	vector<StringPiece> groups(re2->regexp.NumberOfCapturingGroups() + 1), pieces;
+	vector<StringPiece> groups(re2->regexp->NumberOfCapturingGroups() + 1), pieces;
 	const StringPiece& match = groups[0];
 	size_t lastIndex = 0;
 
-	while (lastIndex < a.size && re2->regexp.Match(str, lastIndex, a.size, RE2::UNANCHORED, &groups[0], groups.size())) {
+	while (lastIndex < a.size && re2->match(str, lastIndex, a.size, RE2::UNANCHORED, &groups[0], groups.size())) {
 		if (match.size()) {
 			pieces.push_back(StringPiece(a.data + lastIndex, match.data() - a.data - lastIndex));
 			lastIndex = match.data() - a.data + match.size();
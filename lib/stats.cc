@@ -0,0 +1,226 @@
+#include "./wrapped_re2.h"
+#include "./stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <uv.h>
+
+
+using std::lock_guard;
+using std::mutex;
+using std::vector;
+
+using v8::Local;
+using v8::Object;
+using v8::Value;
+
+
+std::atomic<bool>   WrappedRE2::collectStats(false);
+std::atomic<double> WrappedRE2::slowMatchThreshold(50);
+MatchStats          WrappedRE2::totals;
+
+
+// a slow match is measured by wall-clock throughput: a call is slow, when it scans at least minSlowMatchSize bytes,
+// and spends more than slowMatchThreshold nanoseconds per byte. It depends on a machine and its load.
+// RE2 does not report DFA failures or cache resets, so they are not counted: they only show up, if they make calls slow.
+
+static const size_t minSlowMatchSize = 1024;
+
+bool WrappedRE2::matchWithStats(const StringPiece& text, size_t start, size_t end, RE2::Anchor anchor, StringPiece* groups, int n) {
+	std::chrono::steady_clock::time_point from = std::chrono::steady_clock::now();
+	bool result = regexp->Match(text, start, end, anchor, groups, n);
+	uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - from).count();
+
+	uint64_t size = end > start ? end - start : 0;
+	bool slow = size >= minSlowMatchSize && time > slowMatchThreshold.load(std::memory_order_relaxed) * size;
+
+	stats.add(size, time, slow);
+	totals.add(size, time, slow);
+
+	if (slow) {
+		SlowMatch event = {source, getFlags(), size, time};
+		reportSlowMatch(event);
+	}
+
+	return result;
+}
+
+
+// slow matches are queued, and delivered with uv_async_t to onSlowMatch hooks: every isolate (the main thread,
+// or a worker thread) can set its own hook, and every hook receives slow matches of the whole process
+
+static const size_t maxPendingSlowMatches = 1024;
+
+struct SlowMatchListener {
+	uv_async_t          notifier;
+	Nan::Callback*      hook;
+	Nan::AsyncResource* resource;
+	vector<SlowMatch>   pending; // guarded by listenersGuard
+};
+
+static mutex                           listenersGuard;
+static vector<SlowMatchListener*>      listeners;
+static std::atomic<size_t>             listenerCount(0);
+static thread_local SlowMatchListener* listener = NULL; // of the current isolate
+
+void reportSlowMatch(const SlowMatch& event) {
+	if (!listenerCount.load(std::memory_order_relaxed)) {
+		return;
+	}
+	lock_guard<mutex> lock(listenersGuard);
+	for (size_t i = 0; i < listeners.size(); ++i) {
+		SlowMatchListener* l = listeners[i];
+		if (l->pending.size() < maxPendingSlowMatches) {
+			l->pending.push_back(event);
+			uv_async_send(&l->notifier);
+		}
+	}
+}
+
+static void deliverSlowMatches(uv_async_t* handle) {
+	SlowMatchListener* l = static_cast<SlowMatchListener*>(handle->data);
+	vector<SlowMatch> events;
+	{
+		lock_guard<mutex> lock(listenersGuard);
+		events.swap(l->pending);
+	}
+
+	Nan::HandleScope scope;
+	for (size_t i = 0; i < events.size(); ++i) {
+		const SlowMatch& event = events[i];
+		Local<Object> info = Nan::New<Object>();
+		Nan::Set(info, Nan::New("source").ToLocalChecked(), Nan::New(event.source).ToLocalChecked());
+		Nan::Set(info, Nan::New("flags").ToLocalChecked(),  Nan::New(event.flags).ToLocalChecked());
+		Nan::Set(info, Nan::New("size").ToLocalChecked(),   Nan::New<v8::Number>(static_cast<double>(event.size)));
+		Nan::Set(info, Nan::New("time").ToLocalChecked(),   Nan::New<v8::Number>(event.nanoseconds / 1e6));
+		Local<Value> argv[] = {info};
+		l->hook->Call(1, argv, l->resource);
+	}
+}
+
+static void onListenerClosed(uv_handle_t* handle) {
+	delete static_cast<SlowMatchListener*>(reinterpret_cast<uv_async_t*>(handle)->data);
+}
+
+// unregisters a listener of the current isolate: when its hook is removed, or when its environment is torn down
+static void closeListener(void* arg) {
+	SlowMatchListener* l = static_cast<SlowMatchListener*>(arg);
+	{
+		lock_guard<mutex> lock(listenersGuard);
+		listeners.erase(std::find(listeners.begin(), listeners.end(), l));
+		listenerCount.store(listeners.size());
+	}
+	delete l->hook;
+	delete l->resource;
+	l->hook     = NULL;
+	l->resource = NULL;
+	uv_close(reinterpret_cast<uv_handle_t*>(&l->notifier), onListenerClosed);
+	if (listener == l) {
+		listener = NULL;
+	}
+}
+
+static void openListener() {
+	SlowMatchListener* l = new SlowMatchListener();
+	l->hook     = NULL;
+	l->resource = new Nan::AsyncResource("re2:onSlowMatch");
+	l->notifier.data = l;
+	uv_async_init(Nan::GetCurrentEventLoop(), &l->notifier, deliverSlowMatches);
+	uv_unref(reinterpret_cast<uv_handle_t*>(&l->notifier)); // it should not keep a process alive
+#if NODE_MAJOR_VERSION >= 10
+	node::AddEnvironmentCleanupHook(v8::Isolate::GetCurrent(), closeListener, l);
+#endif
+	listener = l;
+
+	lock_guard<mutex> lock(listenersGuard);
+	listeners.push_back(l);
+	listenerCount.store(listeners.size());
+}
+
+
+// JavaScript interface
+
+static Local<Object> toObject(const MatchStats& stats) {
+	Local<Object> result = Nan::New<Object>();
+	Nan::Set(result, Nan::New("matches").ToLocalChecked(),     Nan::New<v8::Number>(static_cast<double>(stats.matches.load())));
+	Nan::Set(result, Nan::New("bytes").ToLocalChecked(),       Nan::New<v8::Number>(static_cast<double>(stats.bytes.load())));
+	Nan::Set(result, Nan::New("time").ToLocalChecked(),        Nan::New<v8::Number>(stats.nanoseconds.load() / 1e6));
+	Nan::Set(result, Nan::New("slowMatches").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(stats.slowMatches.load())));
+	if (WrappedRE2::hasFastCalls) {
+		Nan::Set(result, Nan::New("fastCalls").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(stats.fastCalls.load())));
+	}
+	return result;
+}
+
+
+NAN_METHOD(WrappedRE2::GetStats) {
+	WrappedRE2* re2 = Nan::ObjectWrap::Unwrap<WrappedRE2>(info.This());
+	if (!re2) {
+		return Nan::ThrowTypeError("RE2 object was expected.");
+	}
+	info.GetReturnValue().Set(toObject(re2->stats));
+}
+
+
+NAN_METHOD(WrappedRE2::GetGlobalStats) {
+	info.GetReturnValue().Set(toObject(totals));
+}
+
+
+NAN_GETTER(WrappedRE2::GetCollectStats) {
+	info.GetReturnValue().Set(collectStats.load());
+}
+
+
+NAN_SETTER(WrappedRE2::SetCollectStats) {
+	collectStats.store(Nan::To<bool>(value).FromJust());
+}
+
+
+NAN_GETTER(WrappedRE2::GetSlowMatchThreshold) {
+	info.GetReturnValue().Set(slowMatchThreshold.load());
+}
+
+
+NAN_SETTER(WrappedRE2::SetSlowMatchThreshold) {
+	double threshold = value->IsNumber() ? value.As<v8::Number>()->Value() : -1;
+	if (!(threshold >= 0)) {
+		return Nan::ThrowRangeError("slowMatchThreshold should be a non-negative number of nanoseconds per byte.");
+	}
+	slowMatchThreshold.store(threshold);
+}
+
+
+NAN_GETTER(WrappedRE2::GetOnSlowMatch) {
+	if (!listener) {
+		info.GetReturnValue().SetNull();
+		return;
+	}
+	info.GetReturnValue().Set(listener->hook->GetFunction());
+}
+
+
+NAN_SETTER(WrappedRE2::SetOnSlowMatch) {
+	if (!value->IsFunction() && !value->IsNull() && !value->IsUndefined()) {
+		return Nan::ThrowTypeError("onSlowMatch should be a function, or null.");
+	}
+
+	if (!value->IsFunction()) {
+		if (listener) {
+#if NODE_MAJOR_VERSION >= 10
+			node::RemoveEnvironmentCleanupHook(v8::Isolate::GetCurrent(), closeListener, listener);
+#endif
+			closeListener(listener);
+		}
+		return;
+	}
+
+	if (!listener) {
+		openListener();
+	}
+	delete listener->hook;
+	listener->hook = new Nan::Callback(value.As<v8::Function>());
+}
@@ -0,0 +1,45 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+
+#include <atomic>
+#include <string>
+
+#include <stdint.h>
+
+
+// Matching statistics: counters are updated from the main thread, and from the thread pool
+// by asynchronous methods, so they are atomic. They are collected only when RE2.collectStats is on.
+
+struct MatchStats {
+	std::atomic<uint64_t> matches;     // RE2::Match() calls
+	std::atomic<uint64_t> bytes;       // bytes scanned by those calls
+	std::atomic<uint64_t> nanoseconds; // time spent in those calls
+	std::atomic<uint64_t> slowMatches; // calls, which scanned slower than RE2.slowMatchThreshold
+	std::atomic<uint64_t> fastCalls;   // test() and search() calls made by V8 as fast API calls
+
+	MatchStats() : matches(0), bytes(0), nanoseconds(0), slowMatches(0), fastCalls(0) {}
+
+	void add(uint64_t size, uint64_t time, bool slow) {
+		matches.fetch_add(1, std::memory_order_relaxed);
+		bytes.fetch_add(size, std::memory_order_relaxed);
+		nanoseconds.fetch_add(time, std::memory_order_relaxed);
+		if (slow) {
+			slowMatches.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+};
+
+
+// a slow match reported to RE2.onSlowMatch: it can be detected on any thread,
+// so it is queued, and delivered on the main thread
+
+struct SlowMatch {
+	std::string source, flags;
+	uint64_t    size, nanoseconds;
+};
+
+void reportSlowMatch(const SlowMatch& event);
+
+
+#endif
@@ -22,42 +22,29 @@ NAN_METHOD(WrappedRE2::Test) {
 		return;
 	}
 
-	StrVal str(info[0]);
+	// only booleans are returned below, so a subject can be borrowed from the V8 heap
+	StrVal str(info[0], StrVal::BORROW_FLAT);
 	if (!str.data) {
 		return;
 	}
 
 	size_t lastIndex = 0;
 
-	if (str.isBuffer) {
-		if ((re2->global || re2->sticky) && re2->lastIndex) {
-			if (re2->lastIndex > str.size) {
-				re2->lastIndex = 0;
-				info.GetReturnValue().Set(false);
-				return;
-			}
-			lastIndex = re2->lastIndex;
-		}
-	} else {
-		if ((re2->global || re2->sticky) && re2->lastIndex) {
-			if (re2->lastIndex > str.length) {
-				re2->lastIndex = 0;
-				info.GetReturnValue().Set(false);
-				return;
-			}
-			for (size_t n = re2->lastIndex; n; --n) {
-				lastIndex += getUtf8CharSize(str.data[lastIndex]);
-			}
+	if ((re2->global || re2->sticky) && re2->lastIndex) {
+		if (re2->lastIndex > str.length) {
+			re2->lastIndex = 0;
+			info.GetReturnValue().Set(false);
+			return;
 		}
+		lastIndex = str.getUtf8Offset(re2->lastIndex);
 	}
 
 	// actual work
 
 	if (re2->global || re2->sticky) {
 		StringPiece match;
-		if (re2->regexp.Match(str, lastIndex, str.size, re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED, &match, 1)) {
-			re2->lastIndex += str.isBuffer ? match.data() - str.data + match.size() - lastIndex :
-				getUtf16Length(str.data + lastIndex, match.data() + match.size());
+		if (re2->match(str, lastIndex, str.size, re2->sticky ? RE2::ANCHOR_START : RE2::UNANCHORED, &match, 1)) {
+			re2->lastIndex = str.getUtf16Offset(match.data() - str.data + match.size());
 			info.GetReturnValue().Set(true);
 			return;
 		}
@@ -66,5 +53,5 @@ NAN_METHOD(WrappedRE2::Test) {
 		return;
 	}
 
-	info.GetReturnValue().Set(re2->regexp.Match(str, lastIndex, str.size, RE2::UNANCHORED, NULL, 0));
+	info.GetReturnValue().Set(re2->match(str, lastIndex, str.size, RE2::UNANCHORED, NULL, 0));
 }
@@ -20,7 +20,7 @@ NAN_METHOD(WrappedRE2::ToString) {
 	// actual work
 
 	string buffer("/");
-	buffer += re2->regexp.pattern();
+	buffer += re2->regexp->pattern();
 	buffer += "/";
 
 	if (re2->global) {
@@ -0,0 +1,261 @@
+#include "./utf.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF_SSE2 1
+#include <emmintrin.h>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define UTF_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#define UTF_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+// Semantics shared by all kernels:
+//  - getUtf16Length() counts every byte, which is not a continuation byte (10xxxxxx),
+//    plus one more for every leading byte of a 4-byte sequence (11110xxx and up),
+//    so a truncated sequence at the end is counted as a whole character;
+//  - getUtf8Length() counts 1, 2, or 3 bytes per code unit depending on its value,
+//    and 2 bytes for each surrogate, so a surrogate pair takes 4 bytes.
+
+
+static inline unsigned popCount(unsigned x) {
+#ifdef _MSC_VER
+	return __popcnt(x);
+#else
+	return __builtin_popcount(x);
+#endif
+}
+
+static inline unsigned countTrailingZeros(unsigned x) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, x);
+	return index;
+#else
+	return __builtin_ctz(x);
+#endif
+}
+
+
+// scalar kernels (also used for tails)
+
+static size_t getUtf16LengthScalar(const unsigned char* from, const unsigned char* to) {
+	size_t n = 0;
+	for (; from != to; ++from) {
+		unsigned ch = *from;
+		n += ((ch & 0xC0) != 0x80) + (ch >= 0xF0);
+	}
+	return n;
+}
+
+static size_t getUtf8LengthScalar(const uint16_t* from, const uint16_t* to) {
+	size_t n = 0;
+	for (; from != to; ++from) {
+		uint16_t ch = *from;
+		if (ch <= 0x7F) n += 1;
+		else if (ch <= 0x7FF) n += 2;
+		else if (0xD800 <= ch && ch <= 0xDFFF) n += 2;
+		else n += 3;
+	}
+	return n;
+}
+
+static const char* findNonAsciiScalar(const char* from, const char* to) {
+	for (; from != to; ++from) {
+		if (*from & 0x80) break;
+	}
+	return from;
+}
+
+
+#if UTF_SSE2
+
+static size_t getUtf16LengthSse2(const unsigned char* from, const unsigned char* to) {
+	size_t n = 0;
+	const __m128i continuation = _mm_set1_epi8(-64), fourBytes = _mm_set1_epi8(static_cast<char>(0xF0));
+	for (; to - from >= 16; from += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from));
+		unsigned cont = _mm_movemask_epi8(_mm_cmplt_epi8(v, continuation));
+		unsigned four = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, fourBytes), v));
+		n += 16 - popCount(cont) + popCount(four);
+	}
+	return n + getUtf16LengthScalar(from, to);
+}
+
+static size_t getUtf8LengthSse2(const uint16_t* from, const uint16_t* to) {
+	size_t n = 0;
+	const __m128i limit1 = _mm_set1_epi16(0x7F), limit2 = _mm_set1_epi16(0x7FF),
+		surrogateMask = _mm_set1_epi16(static_cast<short>(0xF800)), surrogate = _mm_set1_epi16(static_cast<short>(0xD800)),
+		zero = _mm_setzero_si128();
+	for (; to - from >= 8; from += 8) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from));
+		// each mask holds -1 in a lane, where a condition is true
+		__m128i oneByte = _mm_cmpeq_epi16(_mm_subs_epu16(v, limit1), zero),
+			twoBytes = _mm_cmpeq_epi16(_mm_subs_epu16(v, limit2), zero),
+			pair = _mm_cmpeq_epi16(_mm_and_si128(v, surrogateMask), surrogate);
+		unsigned less = popCount(_mm_movemask_epi8(oneByte)) + popCount(_mm_movemask_epi8(twoBytes)) +
+			popCount(_mm_movemask_epi8(pair));
+		n += 24 - less / 2;
+	}
+	return n + getUtf8LengthScalar(from, to);
+}
+
+static const char* findNonAsciiSse2(const char* from, const char* to) {
+	for (; to - from >= 16; from += 16) {
+		unsigned mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(from)));
+		if (mask) return from + countTrailingZeros(mask);
+	}
+	return findNonAsciiScalar(from, to);
+}
+
+#endif
+
+
+#if UTF_AVX2
+
+__attribute__((target("avx2")))
+static size_t getUtf16LengthAvx2(const unsigned char* from, const unsigned char* to) {
+	size_t n = 0;
+	const __m256i continuation = _mm256_set1_epi8(-64), fourBytes = _mm256_set1_epi8(static_cast<char>(0xF0));
+	for (; to - from >= 32; from += 32) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from));
+		unsigned cont = _mm256_movemask_epi8(_mm256_cmpgt_epi8(continuation, v));
+		unsigned four = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v, fourBytes), v));
+		n += 32 - popCount(cont) + popCount(four);
+	}
+	return n + getUtf16LengthSse2(from, to);
+}
+
+__attribute__((target("avx2")))
+static size_t getUtf8LengthAvx2(const uint16_t* from, const uint16_t* to) {
+	size_t n = 0;
+	const __m256i limit1 = _mm256_set1_epi16(0x7F), limit2 = _mm256_set1_epi16(0x7FF),
+		surrogateMask = _mm256_set1_epi16(static_cast<short>(0xF800)), surrogate = _mm256_set1_epi16(static_cast<short>(0xD800)),
+		zero = _mm256_setzero_si256();
+	for (; to - from >= 16; from += 16) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from));
+		__m256i oneByte = _mm256_cmpeq_epi16(_mm256_subs_epu16(v, limit1), zero),
+			twoBytes = _mm256_cmpeq_epi16(_mm256_subs_epu16(v, limit2), zero),
+			pair = _mm256_cmpeq_epi16(_mm256_and_si256(v, surrogateMask), surrogate);
+		unsigned less = popCount(_mm256_movemask_epi8(oneByte)) + popCount(_mm256_movemask_epi8(twoBytes)) +
+			popCount(_mm256_movemask_epi8(pair));
+		n += 48 - less / 2;
+	}
+	return n + getUtf8LengthSse2(from, to);
+}
+
+__attribute__((target("avx2")))
+static const char* findNonAsciiAvx2(const char* from, const char* to) {
+	for (; to - from >= 32; from += 32) {
+		unsigned mask = _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(from)));
+		if (mask) return from + countTrailingZeros(mask);
+	}
+	return findNonAsciiSse2(from, to);
+}
+
+#endif
+
+
+#if UTF_NEON
+
+static size_t getUtf16LengthNeon(const unsigned char* from, const unsigned char* to) {
+	size_t n = 0;
+	const uint8x16_t continuationMask = vdupq_n_u8(0xC0), continuation = vdupq_n_u8(0x80), fourBytes = vdupq_n_u8(0xF0);
+	const uint8x16_t one = vdupq_n_u8(1);
+	for (; to - from >= 16; from += 16) {
+		uint8x16_t v = vld1q_u8(from);
+		// per byte: 1 for a non-continuation byte, plus 1 for a 4-byte leader
+		uint8x16_t lead = vmvnq_u8(vceqq_u8(vandq_u8(v, continuationMask), continuation));
+		uint8x16_t four = vcgeq_u8(v, fourBytes);
+		uint8x16_t counts = vaddq_u8(vandq_u8(lead, one), vandq_u8(four, one));
+		n += vaddlvq_u8(counts);
+	}
+	return n + getUtf16LengthScalar(from, to);
+}
+
+static size_t getUtf8LengthNeon(const uint16_t* from, const uint16_t* to) {
+	size_t n = 0;
+	const uint16x8_t limit1 = vdupq_n_u16(0x80), limit2 = vdupq_n_u16(0x800),
+		surrogateMask = vdupq_n_u16(0xF800), surrogate = vdupq_n_u16(0xD800), one = vdupq_n_u16(1);
+	for (; to - from >= 8; from += 8) {
+		uint16x8_t v = vld1q_u16(from);
+		// 1 + (ch >= 0x80) + (ch >= 0x800) - (ch is a surrogate)
+		uint16x8_t counts = vaddq_u16(one, vaddq_u16(vandq_u16(vcgeq_u16(v, limit1), one), vandq_u16(vcgeq_u16(v, limit2), one)));
+		counts = vsubq_u16(counts, vandq_u16(vceqq_u16(vandq_u16(v, surrogateMask), surrogate), one));
+		n += vaddvq_u16(counts);
+	}
+	return n + getUtf8LengthScalar(from, to);
+}
+
+static const char* findNonAsciiNeon(const char* from, const char* to) {
+	for (; to - from >= 16; from += 16) {
+		uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(from));
+		if (vmaxvq_u8(v) & 0x80) return findNonAsciiScalar(from, from + 16);
+	}
+	return findNonAsciiScalar(from, to);
+}
+
+#endif
+
+
+// run-time dispatch
+
+typedef size_t (*Utf16LengthKernel)(const unsigned char*, const unsigned char*);
+typedef size_t (*Utf8LengthKernel)(const uint16_t*, const uint16_t*);
+typedef const char* (*FindNonAsciiKernel)(const char*, const char*);
+
+struct Kernels {
+	Utf16LengthKernel  utf16Length;
+	Utf8LengthKernel   utf8Length;
+	FindNonAsciiKernel findNonAscii;
+
+	Kernels() {
+#if UTF_AVX2
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) {
+			utf16Length  = getUtf16LengthAvx2;
+			utf8Length   = getUtf8LengthAvx2;
+			findNonAscii = findNonAsciiAvx2;
+			return;
+		}
+#endif
+#if UTF_SSE2
+		utf16Length  = getUtf16LengthSse2;
+		utf8Length   = getUtf8LengthSse2;
+		findNonAscii = findNonAsciiSse2;
+#elif UTF_NEON
+		utf16Length  = getUtf16LengthNeon;
+		utf8Length   = getUtf8LengthNeon;
+		findNonAscii = findNonAsciiNeon;
+#else
+		utf16Length  = getUtf16LengthScalar;
+		utf8Length   = getUtf8LengthScalar;
+		findNonAscii = findNonAsciiScalar;
+#endif
+	}
+};
+
+static const Kernels& getKernels() {
+	static const Kernels kernels;
+	return kernels;
+}
+
+
+size_t getUtf8Length(const uint16_t* from, const uint16_t* to) {
+	return getKernels().utf8Length(from, to);
+}
+
+size_t getUtf16Length(const char* from, const char* to) {
+	return getKernels().utf16Length(reinterpret_cast<const unsigned char*>(from), reinterpret_cast<const unsigned char*>(to));
+}
+
+const char* findNonAscii(const char* from, const char* to) {
+	return getKernels().findNonAscii(from, to);
+}
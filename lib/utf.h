@@ -0,0 +1,26 @@
+#ifndef UTF_H_
+#define UTF_H_
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// UTF-8/UTF-16 length utilities
+// (vectorized with SSE2/AVX2/NEON where available, selected at run time)
+
+size_t getUtf8Length(const uint16_t* from, const uint16_t* to);
+size_t getUtf16Length(const char* from, const char* to);
+
+const char* findNonAscii(const char* from, const char* to);
+
+inline bool isAscii(const char* from, const char* to) {
+	return findNonAscii(from, to) == to;
+}
+
+inline size_t getUtf8CharSize(char ch) {
+	return ((0xE5000000 >> ((ch >> 3) & 0x1E)) & 3) + 1;
+}
+
+
+#endif
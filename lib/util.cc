@@ -1,8 +1,15 @@
 #include "./util.h"
 
+#include <algorithm>
+#include <memory>
+
 #include <node_buffer.h>
 
 
+using std::make_shared;
+using std::shared_ptr;
+using std::upper_bound;
+
 using v8::Local;
 using v8::MaybeLocal;
 using v8::String;
@@ -10,20 +17,346 @@ using v8::Value;
 using v8::Isolate;
 
 
-StrVal::StrVal(const Local<Value>& arg) : data(NULL), size(0), isBuffer(false) {
+// one-byte (Latin-1) strings: ASCII is byte-compatible with UTF-8, so they are copied as is with WriteOneByte(),
+// instead of being measured with Utf8Length(), and encoded with WriteUtf8(). Other Latin-1 characters are expanded
+// to two bytes in place.
+
+static size_t writeOneByte(const Local<String>& s, size_t length, std::vector<char>& storage) {
+	if (storage.size() < length + 1) {
+		storage.resize(length + 1);
+	}
+	char* data = &storage[0];
+	writeOneByteChars(s, reinterpret_cast<uint8_t*>(data));
+
+	const char* nonAscii = findNonAscii(data, data + length);
+	if (nonAscii == data + length) {
+		return length;
+	}
+
+	size_t from = nonAscii - data, size = length;
+	for (size_t i = from; i < length; ++i) {
+		size += static_cast<unsigned char>(data[i]) >> 7;
+	}
+	if (storage.size() < size + 1) {
+		storage.resize(size + 1);
+		data = &storage[0];
+	}
+	data[size] = '\0';
+	for (size_t i = length, j = size; i > from;) {
+		unsigned char ch = data[--i];
+		if (ch < 0x80) {
+			data[--j] = ch;
+		} else {
+			data[--j] = static_cast<char>(0x80 | (ch & 0x3F));
+			data[--j] = static_cast<char>(0xC0 | (ch >> 6));
+		}
+	}
+	return size;
+}
+
+// writes a string as UTF-8 with a terminating zero: storage only grows, so a reused scratch buffer
+// is not reallocated in a steady state
+static size_t writeUtf8(const Local<String>& s, size_t length, std::vector<char>& storage) {
+	if (s->IsOneByte()) {
+		return writeOneByte(s, length, storage);
+	}
+	size_t size = utf8Length(s);
+	if (storage.size() < size + 1) {
+		storage.resize(size + 1);
+	}
+	writeUtf8Chars(s, &storage[0]);
+	return size;
+}
+
+// external one-byte strings keep their characters outside of the V8 heap, so ASCII ones are used in place
+static const char* getExternalAscii(const Local<String>& s, size_t length) {
+	const String::ExternalOneByteStringResource* resource = s->GetExternalOneByteStringResource();
+	if (!resource || resource->length() != length) {
+		return NULL;
+	}
+	const char* data = resource->data();
+	return isAscii(data, data + length) ? data : NULL;
+}
+
+
+// conversion cache: long strings are converted to UTF-8 once, and reused while
+// the same string object is passed again (e.g., exec() loops with the "g" flag)
+
+namespace {
+
+struct CacheEntry {
+	Nan::Persistent<String>          handle;
+	shared_ptr<ConvertedString>      converted;
+};
+
+// short strings are cheaper to convert than to track
+const size_t minCachedLength = 256;
+const size_t cacheSize       = 4;
+
+// every isolate has its own thread, so the cache is per-isolate
+thread_local CacheEntry cache[cacheSize];
+thread_local size_t     nextEntry = 0;
+
+void onCollected(const Nan::WeakCallbackInfo<CacheEntry>& data) {
+	CacheEntry* entry = data.GetParameter();
+	entry->handle.Reset();
+	entry->converted.reset();
+}
+
+shared_ptr<ConvertedString> convert(const Local<String>& s, int length) {
+	shared_ptr<ConvertedString> converted(make_shared<ConvertedString>());
+	converted->length = length;
+	converted->buffer.resize(writeUtf8(s, length, converted->buffer) + 1);
+	return converted;
+}
+
+shared_ptr<ConvertedString> getConverted(const Local<String>& s, int length) {
+	for (size_t i = 0; i < cacheSize; ++i) {
+		CacheEntry& entry = cache[i];
+		if (entry.converted && entry.converted->length == static_cast<size_t>(length) && entry.handle == s) {
+			return entry.converted;
+		}
+	}
+
+	CacheEntry& entry = cache[nextEntry];
+	nextEntry = (nextEntry + 1) % cacheSize;
+
+	entry.converted = convert(s, length);
+	entry.handle.Reset(s);
+	entry.handle.SetWeak(&entry, onCollected, Nan::WeakCallbackType::kParameter);
+
+	return entry.converted;
+}
+
+}
+
+
+// offset index: one checkpoint per indexStep UTF-16 code units
+
+static const size_t indexStep = 64;
+
+void ConvertedString::buildIndex() {
+	const char* data = &buffer[0];
+	size_t size = buffer.size() - 1, utf8 = 0, utf16 = 0, next = 0;
+
+	utf8Offsets.reserve(length / indexStep + 1);
+	utf16Offsets.reserve(length / indexStep + 1);
+
+	while (utf8 < size) {
+		if (utf16 >= next) {
+			utf8Offsets.push_back(utf8);
+			utf16Offsets.push_back(utf16);
+			next += indexStep;
+		}
+		size_t sym_size = getUtf8CharSize(data[utf8]);
+		utf8  += sym_size;
+		utf16 += sym_size < 4 ? 1 : 2;
+	}
+}
+
+
+static size_t scanToUtf16(const char* data, size_t size, size_t utf8, size_t utf16, size_t target) {
+	while (utf16 < target && utf8 < size) {
+		size_t sym_size = getUtf8CharSize(data[utf8]);
+		utf8  += sym_size;
+		utf16 += sym_size < 4 ? 1 : 2;
+	}
+	return utf8 < size ? utf8 : size;
+}
+
+static size_t scanToUtf8(const char* data, size_t utf8, size_t utf16, size_t target) {
+	while (utf8 < target) {
+		size_t sym_size = getUtf8CharSize(data[utf8]);
+		utf8  += sym_size;
+		utf16 += sym_size < 4 ? 1 : 2;
+	}
+	return utf16;
+}
+
+
+size_t StrVal::getUtf8Offset(size_t utf16Offset) const {
+	if (size == length) {
+		return utf16Offset < size ? utf16Offset : size;
+	}
+	if (!converted) {
+		return scanToUtf16(data, size, 0, 0, utf16Offset);
+	}
+	if (converted->utf8Offsets.empty()) {
+		converted->buildIndex();
+	}
+	const std::vector<size_t>& utf16Offsets = converted->utf16Offsets;
+	size_t k = utf16Offset / indexStep;
+	if (k >= utf16Offsets.size()) {
+		k = utf16Offsets.size() - 1;
+	} else if (k && utf16Offsets[k] > utf16Offset) {
+		--k;
+	}
+	return scanToUtf16(data, size, converted->utf8Offsets[k], utf16Offsets[k], utf16Offset);
+}
+
+
+size_t StrVal::getUtf16Offset(size_t utf8Offset) const {
+	if (size == length) {
+		return utf8Offset;
+	}
+	if (!converted) {
+		return scanToUtf8(data, 0, 0, utf8Offset);
+	}
+	if (converted->utf8Offsets.empty()) {
+		converted->buildIndex();
+	}
+	const std::vector<size_t>& utf8Offsets = converted->utf8Offsets;
+	size_t k = upper_bound(utf8Offsets.begin(), utf8Offsets.end(), utf8Offset) - utf8Offsets.begin() - 1;
+	return scanToUtf8(data, utf8Offsets[k], converted->utf16Offsets[k], utf8Offset);
+}
+
+
+// interned property names
+
+static thread_local Nan::Persistent<String> keys[NUMBER_OF_KEYS];
+static const char* keyNames[NUMBER_OF_KEYS] = {"index", "input", "groups", "value", "done"};
+
+Local<String> internString(const char* data, size_t size) {
+	return String::NewFromUtf8(Isolate::GetCurrent(), data, v8::NewStringType::kInternalized, static_cast<int>(size)).ToLocalChecked();
+}
+
+Local<String> getKey(PropertyKey key) {
+	Nan::Persistent<String>& handle = keys[key];
+	if (handle.IsEmpty()) {
+		const char* name = keyNames[key];
+		handle.Reset(internString(name, strlen(name)));
+	}
+	return Nan::New(handle);
+}
+
+void releaseCachedHandles() {
+	for (size_t i = 0; i < NUMBER_OF_KEYS; ++i) {
+		keys[i].Reset();
+	}
+	for (size_t i = 0; i < cacheSize; ++i) {
+		cache[i].handle.Reset();
+		cache[i].converted.reset();
+	}
+}
+
+
+// output buffers
+
+bool OutputBuffer::grow(size_t n) {
+	size_t newCapacity = capacity * 2 > n ? capacity * 2 : n;
+	char* newData = static_cast<char*>(realloc(data, newCapacity));
+	if (!newData) {
+		// the old memory is intact, and freed by the caller or the destructor
+		failed = true;
+		return false;
+	}
+	data = newData;
+	capacity = newCapacity;
+	return true;
+}
+
+
+namespace {
+
+// long ASCII results become external strings, which use our memory as is;
+// short strings are cheaper to copy than to track
+const size_t minExternalLength = 1024;
+
+class ExternalOutput : public String::ExternalOneByteStringResource {
+	public:
+		ExternalOutput(char* data, size_t size) : data_(data), size_(size) {}
+		~ExternalOutput() { free(data_); }
+
+		const char* data() const { return data_; }
+		size_t length() const { return size_; }
+
+	private:
+		char*  data_;
+		size_t size_;
+};
+
+}
+
+
+Local<Value> OutputBuffer::toValue(bool asBuffer) {
+	if (asBuffer) {
+		if (!size) {
+			return Nan::NewBuffer(0).ToLocalChecked();
+		}
+		// the buffer frees the memory with free()
+		Local<Value> buffer = Nan::NewBuffer(data, size).ToLocalChecked();
+		data = NULL;
+		size = capacity = 0;
+		return buffer;
+	}
+	if (size >= minExternalLength && isAscii(data, data + size)) {
+		ExternalOutput* resource = new ExternalOutput(data, size);
+		data = NULL;
+		size = capacity = 0;
+		MaybeLocal<String> result = Nan::New<String>(resource);
+		if (result.IsEmpty()) {
+			// V8 did not take the ownership
+			delete resource;
+			Nan::ThrowRangeError("Invalid string length");
+			return Nan::Undefined();
+		}
+		return result.ToLocalChecked();
+	}
+	return Nan::New(data, static_cast<int>(size)).ToLocalChecked();
+}
+
+
+static char emptyData[1] = {0};
+
+
+StrVal::StrVal(const Local<Value>& arg, Access access) : data(NULL), size(0), isBuffer(false) {
+	init(arg, buffer, access);
+}
+
+
+StrVal::StrVal(const Local<Value>& arg, std::vector<char>& scratch) : data(NULL), size(0), isBuffer(false) {
+	init(arg, scratch, BORROW_EXTERNAL);
+}
+
+
+void StrVal::init(const Local<Value>& arg, std::vector<char>& storage, Access access) {
 	if (node::Buffer::HasInstance(arg)) {
 		isBuffer = true;
 		size = length = node::Buffer::Length(arg);
 		data = node::Buffer::Data(arg);
+		if (!data) {
+			// an empty buffer can have no memory, while NULL means an error
+			data = emptyData;
+		}
 	} else {
 		MaybeLocal<String> t(arg->ToString(Isolate::GetCurrent()->GetCurrentContext()));
 		if (!t.IsEmpty()) {
 			Local<String> s = t.ToLocalChecked();
 			length = s->Length();
-			size = s->Utf8Length();
-			buffer.resize(size + 1);
-			data = &buffer[0];
-			s->WriteUtf8(data);
+			// an external string is alive while its handle is, and its characters are never modified
+			const char* borrowed = access != COPY ? getExternalAscii(s, length) : NULL;
+#ifdef RE2_STRING_VIEWS
+			if (!borrowed && access == BORROW_FLAT && length && s->IsOneByte()) {
+				view.reset(new String::ValueView(Isolate::GetCurrent(), s));
+				const char* chars = reinterpret_cast<const char*>(view->data8());
+				if (isAscii(chars, chars + length)) {
+					borrowed = chars;
+				} else {
+					view.reset(); // V8 is called below
+				}
+			}
+#endif
+			if (borrowed) {
+				size = length;
+				data = const_cast<char*>(borrowed);
+			} else if (length >= minCachedLength) {
+				converted = getConverted(s, length);
+				size = converted->buffer.size() - 1;
+				data = &converted->buffer[0];
+			} else {
+				size = writeUtf8(s, length, storage);
+				data = &storage[0];
+			}
 		}
 	}
 }
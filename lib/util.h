@@ -3,21 +3,198 @@
 
 #include "./wrapped_re2.h"
 
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
 #include <vector>
 
 
+// V8 API differences: string methods take an isolate since V8 7, and versions without it are removed in V8 11;
+// ArrayBuffer::GetContents() is replaced with GetBackingStore() since V8 8
+
+inline int utf8Length(const v8::Local<v8::String>& s) {
+#if V8_MAJOR_VERSION >= 7
+	return s->Utf8Length(v8::Isolate::GetCurrent());
+#else
+	return s->Utf8Length();
+#endif
+}
+
+inline int writeUtf8Chars(const v8::Local<v8::String>& s, char* buffer, int size = -1, int options = v8::String::NO_OPTIONS) {
+#if V8_MAJOR_VERSION >= 7
+	return s->WriteUtf8(v8::Isolate::GetCurrent(), buffer, size, NULL, options);
+#else
+	return s->WriteUtf8(buffer, size, NULL, options);
+#endif
+}
+
+inline int writeOneByteChars(const v8::Local<v8::String>& s, uint8_t* buffer) {
+#if V8_MAJOR_VERSION >= 7
+	return s->WriteOneByte(v8::Isolate::GetCurrent(), buffer);
+#else
+	return s->WriteOneByte(buffer);
+#endif
+}
+
+inline void* getArrayBufferData(const v8::Local<v8::ArrayBuffer>& buffer) {
+#if V8_MAJOR_VERSION >= 8
+	return buffer->GetBackingStore()->Data();
+#else
+	return buffer->GetContents().Data();
+#endif
+}
+
+
+// String::ValueView gives access to characters of strings on the V8 heap without copying (V8 13+)
+
+#if V8_MAJOR_VERSION >= 13
+#define RE2_STRING_VIEWS
+#endif
+
+
+// UTF-8 representation of a JS string, shared by all calls made on the same subject
+
+struct ConvertedString {
+	std::vector<char> buffer;
+	size_t length;
+
+	// sparse UTF-16 <-> UTF-8 offset index, built on demand for non-ASCII strings
+	std::vector<size_t> utf8Offsets, utf16Offsets;
+
+	ConvertedString() : length(0) {}
+
+	void buildIndex();
+};
+
+
 struct StrVal {
+	// ASCII strings can be used in place instead of being copied
+	enum Access {
+		COPY,            // nothing is borrowed: an object, which is used on the thread pool, should not depend
+		                 // on an isolate, which can be disposed meanwhile
+		BORROW_EXTERNAL, // external strings are borrowed: their characters are outside of the V8 heap (the default)
+		BORROW_FLAT      // strings on the V8 heap are borrowed too, where V8 supports it: V8 should not be called
+		                 // at all (no allocations, no exceptions), while an object is alive
+	};
+
 	std::vector<char> buffer;
+	std::shared_ptr<ConvertedString> converted;
 	char*  data;
 	size_t size, length;
 	bool   isBuffer;
 
 	StrVal() : data(NULL), size(0), length(0), isBuffer(false) {}
-	StrVal(const v8::Local<v8::Value>& arg);
+	StrVal(const v8::Local<v8::Value>& arg, Access access = BORROW_EXTERNAL);
+	// short strings are converted into a caller-owned scratch buffer, which should outlive this object
+	StrVal(const v8::Local<v8::Value>& arg, std::vector<char>& scratch);
 
 	operator StringPiece () const { return StringPiece(data, size); }
+
+	// offset translation: for buffers and ASCII strings both are identity functions
+	size_t getUtf8Offset(size_t utf16Offset) const;
+	size_t getUtf16Offset(size_t utf8Offset) const;
+
+	private:
+		void init(const v8::Local<v8::Value>& arg, std::vector<char>& storage, Access access);
+
+#ifdef RE2_STRING_VIEWS
+		std::unique_ptr<v8::String::ValueView> view;
+#endif
+};
+
+
+// growable output of replace(): its malloc'ed memory is handed over to V8 without copying
+
+struct OutputBuffer {
+	char*  data;
+	size_t size, capacity;
+	bool   failed; // memory could not be allocated: nothing is appended anymore, and the result should be discarded
+
+	OutputBuffer() : data(NULL), size(0), capacity(0), failed(false) {}
+	~OutputBuffer() { free(data); }
+
+	// grows geometrically, so appending is amortized O(1); returns false, when out of memory
+	bool reserve(size_t n) {
+		return !failed && (n <= capacity || grow(n));
+	}
+
+	bool append(const char* s, size_t n) {
+		if (!n) return true;
+		if (!reserve(size + n)) return false;
+		memcpy(data + size, s, n);
+		size += n;
+		return true;
+	}
+
+	// frees the memory early, e.g., after a failure
+	void release() {
+		free(data);
+		data = NULL;
+		size = capacity = 0;
+	}
+
+	// transfers the memory to a Buffer, or to an external string, when possible; the object is empty afterwards
+	v8::Local<v8::Value> toValue(bool asBuffer);
+
+	private:
+		OutputBuffer(const OutputBuffer&);
+		OutputBuffer& operator=(const OutputBuffer&);
+
+		bool grow(size_t n);
+};
+
+
+// interned property names, created once
+
+enum PropertyKey { KEY_INDEX, KEY_INPUT, KEY_GROUPS, KEY_VALUE, KEY_DONE, NUMBER_OF_KEYS };
+
+v8::Local<v8::String> getKey(PropertyKey key);
+v8::Local<v8::String> internString(const char* data, size_t size);
+
+// releases interned keys, and the conversion cache of the current isolate
+void releaseCachedHandles();
+
+// exec()-like result: matched groups, index, input, and named groups
+v8::Local<v8::Array> formExecResult(const WrappedRE2* re2, const StrVal& str, const StringPiece* groups, size_t size, const v8::Local<v8::Value>& input);
+
+// replacement string compiled into a list of literals and group references
+
+struct ReplacementTemplate {
+	enum OpType { LITERAL, GROUP, PREFIX, SUFFIX };
+
+	struct Op {
+		OpType type;
+		size_t offset, size; // literals point into text
+		int    group;
+	};
+
+	std::string     text;
+	std::vector<Op> ops;
+	int             maxGroup;
+	size_t          literalSize;
+
+	ReplacementTemplate(const RE2& regexp, const char* data, size_t size);
+
+	// appends a replacement of groups[0] found in str
+	void apply(const StringPiece* groups, const StringPiece& str, OutputBuffer& result) const;
+
+	private:
+		void addLiteral(size_t offset, size_t size);
+		void addGroup(OpType type, int group);
 };
 
+// string replacement without V8: returns true, if anything was matched; matchEnd is a byte offset past the last match
+bool replaceWithString(WrappedRE2* re2, const StringPiece& str, size_t lastIndex,
+	const ReplacementTemplate& replacer, OutputBuffer& result, size_t& matchEnd);
+
+
+bool translateRegExp(const char* data, size_t size, std::vector<char>& buffer);
+std::string escapeRegExp(const char* data, size_t size);
+
+// pattern arguments of RE2.Set and RE2.FilteredSet: converts a pattern to the RE2 syntax, and produces its source
+bool parseFlags(const v8::Local<v8::Value>& arg, bool& ignoreCase, bool& multiline);
+bool getPattern(const v8::Local<v8::Value>& arg, std::vector<char>& buffer, std::string& source, StringPiece& pattern);
 
 void consoleCall(const v8::Local<v8::String>& methodName, Local<v8::Value> text);
 void printDeprecationWarning(const char* warning);
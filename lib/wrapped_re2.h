@@ -7,7 +7,14 @@
 
 #include <re2/re2.h>
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "./environment.h"
+#include "./utf.h"
+#include "./stats.h"
 
 
 using v8::Function;
@@ -20,11 +27,14 @@ using re2::RE2;
 using re2::StringPiece;
 
 
-class WrappedRE2 : public Nan::ObjectWrap {
+struct ReplacementTemplate;
+
+
+class WrappedRE2 : public TrackedObjectWrap {
 
 	private:
-		WrappedRE2(const StringPiece& pattern, const RE2::Options& options, const std::string& s,
-			const bool& g, const bool& i, const bool& m, const bool& y) : regexp(pattern, options),
+		WrappedRE2(const std::shared_ptr<const RE2>& r, const std::string& s,
+			const bool& g, const bool& i, const bool& m, const bool& y) : regexp(r),
 				source(s), global(g), ignoreCase(i), multiline(m), sticky(y), lastIndex(0) {}
 
 		static NAN_METHOD(New);
@@ -40,26 +50,81 @@ class WrappedRE2 : public Nan::ObjectWrap {
 		static NAN_GETTER(GetLastIndex);
 		static NAN_SETTER(SetLastIndex);
 		static NAN_GETTER(GetInternalSource);
+		static NAN_GETTER(GetProgramSize);
+		static NAN_GETTER(GetReverseProgramSize);
+		static NAN_GETTER(GetMaxMem);
+
+		// test() and search() get V8 fast API versions, where they are available (see fast_calls.cc)
+		static void SetTestAndSearch(Local<FunctionTemplate> tpl);
 
 		// RegExp methods
 		static NAN_METHOD(Exec);
 		static NAN_METHOD(Test);
+		static NAN_METHOD(ExecInto);
+		static NAN_METHOD(ExecLazy);
 
 		// String methods
 		static NAN_METHOD(Match);
+		static NAN_METHOD(MatchAll);
 		static NAN_METHOD(Replace);
 		static NAN_METHOD(Search);
 		static NAN_METHOD(Split);
 
+		// batch methods: one native call for many subjects
+		static NAN_METHOD(TestMany);
+		static NAN_METHOD(SearchMany);
+		static NAN_METHOD(ExecMany);
+
+		// a multi-threaded scan of one large buffer
+		static NAN_METHOD(MatchAllParallel);
+
+		// asynchronous methods: the last argument is a node-style callback
+		static NAN_METHOD(ExecAsync);
+		static NAN_METHOD(TestAsync);
+		static NAN_METHOD(MatchAllAsync);
+		static NAN_METHOD(ReplaceAsync);
+
+		// streaming: a scanner over successive buffer chunks
+		static NAN_METHOD(CreateScanner);
+
+		// memory-mapped files: RE2.scanFile(path, re, options)
+		static NAN_METHOD(ScanFile);
+		static NAN_METHOD(ScanFileAsync);
+
 		// strict Unicode warning support
 		static NAN_GETTER(GetUnicodeWarningLevel);
 		static NAN_SETTER(SetUnicodeWarningLevel);
 
-		static Nan::Persistent<Function>			constructor;
-		static Nan::Persistent<FunctionTemplate>	ctorTemplate;
+		// compiled-pattern cache support
+		static NAN_METHOD(GetCacheStats);
+		static NAN_METHOD(ClearCache);
+		static NAN_GETTER(GetCacheCapacity);
+		static NAN_SETTER(SetCacheCapacity);
+
+		// matching statistics
+		static NAN_METHOD(GetStats);
+		static NAN_METHOD(GetGlobalStats);
+		static NAN_GETTER(GetCollectStats);
+		static NAN_SETTER(SetCollectStats);
+		static NAN_GETTER(GetSlowMatchThreshold);
+		static NAN_SETTER(SetSlowMatchThreshold);
+		static NAN_GETTER(GetOnSlowMatch);
+		static NAN_SETTER(SetOnSlowMatch);
+
+		// sharing compiled programs with other isolates (worker threads)
+		static NAN_METHOD(Share);
+
+		// every isolate has its own thread, so these handles are per-isolate
+		static thread_local Nan::Persistent<Function>			constructor;
+		static thread_local Nan::Persistent<FunctionTemplate>	ctorTemplate;
 
 	public:
-		static void Initialize(Handle<Object> exports, Handle<Object> module);
+		~WrappedRE2() {
+			groupsTemplate.Reset();
+			groupNames.Reset();
+		}
+
+		static void Initialize(Handle<Object> exports);
 
 		static inline bool HasInstance(Local<Object> object) {
 			return Nan::New(ctorTemplate)->HasInstance(object);
@@ -69,70 +134,47 @@ class WrappedRE2 : public Nan::ObjectWrap {
 		static UnicodeWarningLevels unicodeWarningLevel;
 		static bool alreadyWarnedAboutUnicode;
 
-		RE2		    regexp;
+		// a compiled pattern is immutable, and can be shared with other objects (see PatternCache)
+		std::shared_ptr<const RE2> regexp;
+
 		std::string source;
 		bool	    global;
 		bool	    ignoreCase;
 		bool	    multiline;
 		bool	    sticky;
 		size_t	    lastIndex;
-};
-
 
-// utilities
-
-inline size_t getUtf8Length(const uint16_t* from, const uint16_t* to) {
-	size_t n = 0;
-	while (from != to) {
-		uint16_t ch = *from++;
-		if (ch <= 0x7F) ++n;
-		else if (ch <= 0x7FF) n += 2;
-		else if (0xD800 <= ch && ch <= 0xDFFF) {
-			n += 4;
-			if (from == to) break;
-			++from;
-		}
-		else if (ch < 0xFFFF) n += 3;
-		else n += 4;
-	}
-	return n;
-}
-
-inline size_t getUtf16Length(const char* from, const char* to) {
-	size_t n = 0;
-	while (from != to) {
-		unsigned ch = *from & 0xFF;
-		if (ch < 0xF0) {
-			if (ch < 0x80) {
-				++from;
-			} else {
-				if (ch < 0xE0) {
-					from += 2;
-					if (from == to + 1) {
-						++n;
-						break;
-					}
-				} else {
-					from += 3;
-					if (from > to && from < to + 3) {
-						++n;
-						break;
-					}
-				}
+		// shape of exec() results: a template of the groups object, and interned names of named groups
+		Nan::Persistent<v8::ObjectTemplate> groupsTemplate;
+		Nan::Persistent<v8::Array>          groupNames;
+		std::vector<int>                    groupIndices;
+		void prepareResultShape();
+
+		// compiled replacement string of the last replace() call
+		std::shared_ptr<const ReplacementTemplate> replacementTemplate;
+		std::shared_ptr<const ReplacementTemplate> getReplacementTemplate(const char* data, size_t size);
+
+		// matching statistics: RE2::Match() calls should go through match(), so they can be counted
+		static std::atomic<bool>   collectStats;
+		static std::atomic<double> slowMatchThreshold; // nanoseconds per byte
+		static MatchStats          totals;
+		MatchStats                 stats;
+		static const bool          hasFastCalls; // fast API calls are counted in stats
+
+		bool match(const StringPiece& text, size_t start, size_t end, RE2::Anchor anchor, StringPiece* groups, int n) {
+			if (!collectStats.load(std::memory_order_relaxed)) {
+				return regexp->Match(text, start, end, anchor, groups, n);
 			}
-			++n;
-		} else {
-			from += 4;
-			n += 2;
-			if (from > to && from < to + 4) break;
+			return matchWithStats(text, start, end, anchor, groups, n);
 		}
-	}
-	return n;
-}
+		bool matchWithStats(const StringPiece& text, size_t start, size_t end, RE2::Anchor anchor, StringPiece* groups, int n);
 
-inline size_t getUtf8CharSize(char ch) {
-	return ((0xE5000000 >> ((ch >> 3) & 0x1E)) & 3) + 1;
-}
+		std::string getFlags() const;
+
+		// reusable buffers for execInto(): they only grow, so a steady-state loop does not allocate
+		std::vector<char>        scratch;
+		std::vector<StringPiece> groupsScratch;
+};
 
 
 #endif
@@ -0,0 +1,55 @@
+#ifndef WRAPPED_RE2_FILTERED_SET_H_
+#define WRAPPED_RE2_FILTERED_SET_H_
+
+
+#include "./wrapped_re2.h"
+
+#include <re2/filtered_re2.h>
+#include <re2/set.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+class WrappedRE2FilteredSet : public TrackedObjectWrap {
+
+	private:
+		WrappedRE2FilteredSet(int minAtomLength, bool i, bool m) :
+			filter(minAtomLength), ignoreCase(i), multiline(m), lastEvaluated(0) {}
+
+		static NAN_METHOD(New);
+
+		static NAN_GETTER(GetSize);
+		static NAN_GETTER(GetFlags);
+		static NAN_GETTER(GetSources);
+		static NAN_GETTER(GetAtoms);
+		static NAN_GETTER(GetLastEvaluated);
+
+		static NAN_METHOD(Match);
+		static NAN_METHOD(Test);
+
+		static thread_local Nan::Persistent<Function>			constructor;
+		static thread_local Nan::Persistent<FunctionTemplate>	ctorTemplate;
+
+	public:
+		static Local<Function> Initialize();
+
+		static inline bool HasInstance(Local<Object> object) {
+			return Nan::New(ctorTemplate)->HasInstance(object);
+		}
+
+		// returns ids of rules, which should be evaluated for a text
+		void getPotentials(const StringPiece& text, std::vector<int>& potentials) const;
+
+		re2::FilteredRE2            filter;
+		std::unique_ptr<RE2::Set>   atomMatcher;
+		std::vector<std::string>    atoms;
+		std::vector<std::string>    sources;
+		bool                        ignoreCase;
+		bool                        multiline;
+		size_t                      lastEvaluated;
+};
+
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef WRAPPED_RE2_MATCH_ITERATOR_H_
+#define WRAPPED_RE2_MATCH_ITERATOR_H_
+
+
+#include "./wrapped_re2.h"
+#include "./util.h"
+
+#include <memory>
+#include <vector>
+
+
+// an iterator returned by matchAll(): it keeps a converted subject and a cursor,
+// and produces one exec()-like result per next() call
+
+class WrappedRE2MatchIterator : public TrackedObjectWrap {
+
+	private:
+		WrappedRE2MatchIterator() : re2(NULL), lastIndex(0), done(false) {}
+
+		static NAN_METHOD(New);
+		static NAN_METHOD(Next);
+		static NAN_METHOD(Self);
+
+		static thread_local Nan::Persistent<Function>			constructor;
+		static thread_local Nan::Persistent<FunctionTemplate>	ctorTemplate;
+
+		void finish();
+
+	public:
+		~WrappedRE2MatchIterator() {
+			regexp.Reset();
+			input.Reset();
+		}
+
+		static Local<Function> Initialize();
+
+		// creates an iterator over a subject, which is converted right away
+		static Nan::MaybeLocal<Object> Create(const Local<Object>& regexp, const Local<v8::Value>& input);
+
+		WrappedRE2*                  re2;
+		Nan::Persistent<Object>      regexp;
+		Nan::Persistent<v8::Value>   input;
+		std::unique_ptr<StrVal>      str;
+		std::vector<StringPiece>     groups;
+		size_t                       lastIndex;
+		bool                         done;
+};
+
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef WRAPPED_RE2_SCANNER_H_
+#define WRAPPED_RE2_SCANNER_H_
+
+
+#include "./wrapped_re2.h"
+#include "./util.h"
+
+#include <vector>
+
+
+// a stateful scanner returned by createScanner(): it takes successive buffer chunks,
+// and reports matches with absolute byte offsets. Only a tail of maxMatchLength bytes
+// (plus a few bytes of context) is kept between chunks.
+
+class WrappedRE2Scanner : public TrackedObjectWrap {
+
+	private:
+		WrappedRE2Scanner() : re2(NULL), maxMatchLength(0), base(0), pos(0), done(false) {}
+
+		static NAN_METHOD(New);
+		static NAN_METHOD(Write);
+		static NAN_METHOD(End);
+		static NAN_GETTER(GetOffset);
+
+		static thread_local Nan::Persistent<Function>			constructor;
+		static thread_local Nan::Persistent<FunctionTemplate>	ctorTemplate;
+
+		// appends a chunk, and adds matches, which cannot be affected by the following chunks, to results
+		void scan(const char* chunk, size_t size, bool final, v8::Local<v8::Array> results);
+
+	public:
+		~WrappedRE2Scanner() { regexp.Reset(); }
+
+		static Local<Function> Initialize();
+
+		static inline bool HasInstance(Local<Object> object) {
+			return Nan::New(ctorTemplate)->HasInstance(object);
+		}
+
+		// throws, and returns an empty handle, when regexp is not an RE2 object
+		static Nan::MaybeLocal<Object> Create(const Local<Object>& regexp, size_t maxMatchLength);
+
+		static const size_t defaultMaxMatchLength = 4096;
+
+		WrappedRE2*              re2;
+		Nan::Persistent<Object>  regexp;
+		size_t                   maxMatchLength;
+		std::vector<char>        data;   // the unprocessed tail of the stream
+		std::vector<StringPiece> groups;
+		uint64_t                 base;   // an absolute offset of data[0]
+		size_t                   pos;    // a scanning position in data
+		bool                     done;
+};
+
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef WRAPPED_RE2_SET_H_
+#define WRAPPED_RE2_SET_H_
+
+
+#include "./wrapped_re2.h"
+
+#include <re2/set.h>
+
+#include <string>
+#include <vector>
+
+
+class WrappedRE2Set : public TrackedObjectWrap {
+
+	private:
+		WrappedRE2Set(const RE2::Options& options, RE2::Anchor anchor, bool i, bool m) :
+			set(options, anchor), anchor(anchor), ignoreCase(i), multiline(m) {}
+
+		static NAN_METHOD(New);
+
+		static NAN_GETTER(GetSize);
+		static NAN_GETTER(GetFlags);
+		static NAN_GETTER(GetAnchor);
+		static NAN_GETTER(GetSources);
+
+		static NAN_METHOD(Match);
+		static NAN_METHOD(Test);
+
+		static thread_local Nan::Persistent<Function>			constructor;
+		static thread_local Nan::Persistent<FunctionTemplate>	ctorTemplate;
+
+	public:
+		static Local<Function> Initialize();
+
+		static inline bool HasInstance(Local<Object> object) {
+			return Nan::New(ctorTemplate)->HasInstance(object);
+		}
+
+		RE2::Set                 set;
+		RE2::Anchor              anchor;
+		std::vector<std::string> sources;
+		bool                     ignoreCase;
+		bool                     multiline;
+};
+
+
+#endif
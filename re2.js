@@ -1,12 +1,80 @@
 "use strict";
 
-var RE2 = require('./build/Release/re2.node');
+var RE2 = require('./build/Release/re2.node').RE2;
 
 if (typeof Symbol != 'undefined') {
 	Symbol.match   && (RE2.prototype[Symbol.match]   = function (str)        { return this.match(str); });
 	Symbol.search  && (RE2.prototype[Symbol.search]  = function (str)        { return this.search(str); });
 	Symbol.replace && (RE2.prototype[Symbol.replace] = function (str, repl)  { return this.replace(str, repl); });
 	Symbol.split   && (RE2.prototype[Symbol.split]   = function (str, limit) { return this.split(str, limit); });
+	Symbol.matchAll && (RE2.prototype[Symbol.matchAll] = function (str)      { return this.matchAll(str); });
 }
 
+// asynchronous methods: native ones take a callback, wrappers return promises
+
+[['execAsync', 1], ['testAsync', 1], ['matchAllAsync', 1], ['replaceAsync', 2]].forEach(function (pair) {
+	var name = pair[0], arity = pair[1], method = RE2.prototype[name];
+	RE2.prototype[name] = function () {
+		var self = this, args = Array.prototype.slice.call(arguments, 0, arity);
+		while (args.length < arity) args.push(undefined);
+		return new Promise(function (resolve, reject) {
+			args.push(function (error, result) {
+				if (error) {
+					reject(error);
+				} else {
+					resolve(result);
+				}
+			});
+			method.apply(self, args);
+		});
+	};
+});
+
+// memory-mapped files: the native function takes a callback, the wrapper returns a promise
+
+RE2.scanFileAsync = (function (scanFileAsync) {
+	return function (path, re, options) {
+		return new Promise(function (resolve, reject) {
+			scanFileAsync(path, re, options, function (error, result) {
+				if (error) {
+					reject(error);
+				} else {
+					resolve(result);
+				}
+			});
+		});
+	};
+})(RE2.scanFileAsync);
+
+// streaming: a Transform stream, which takes buffers (or strings), and produces exec()-like results
+// with absolute byte offsets as index
+
+RE2.prototype.createScanStream = function (options) {
+	var scanner = this.createScanner(options),
+		Transform = require('stream').Transform;
+	return new Transform({
+		readableObjectMode: true,
+		transform: function (chunk, encoding, callback) {
+			var matches;
+			try {
+				matches = scanner.write(typeof chunk == 'string' ? Buffer.from(chunk, encoding) : chunk);
+			} catch (error) {
+				callback(error);
+				return;
+			}
+			for (var i = 0; i < matches.length; ++i) {
+				this.push(matches[i]);
+			}
+			callback();
+		},
+		flush: function (callback) {
+			var matches = scanner.end();
+			for (var i = 0; i < matches.length; ++i) {
+				this.push(matches[i]);
+			}
+			callback();
+		}
+	});
+};
+
 module.exports = RE2;
@@ -0,0 +1,144 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// tests
+
+unit.add(module, [
+	function test_execAsync(t) {
+		"use strict";
+
+		var x = t.startAsync("test_execAsync");
+
+		var re = new RE2("(\\d+)-(?P<b>\\w+)");
+		re.execAsync("x 12-ab y").then(function (result) {
+			eval(t.TEST("t.unify(result, ['12-ab', '12', 'ab'])"));
+			eval(t.TEST("result.index === 2"));
+			eval(t.TEST("result.input === 'x 12-ab y'"));
+			eval(t.TEST("result.groups.b === 'ab'"));
+			return re.execAsync("nothing");
+		}).then(function (result) {
+			eval(t.TEST("result === null"));
+			x.done();
+		});
+	},
+	function test_execAsyncGlobal(t) {
+		"use strict";
+
+		var x = t.startAsync("test_execAsyncGlobal");
+
+		var re = new RE2("б+", "g"), str = "аб ббб б";
+		re.execAsync(str).then(function (result) {
+			eval(t.TEST("result[0] === 'б'"));
+			eval(t.TEST("result.index === 1"));
+			eval(t.TEST("re.lastIndex === 2"));
+			return re.execAsync(str);
+		}).then(function (result) {
+			eval(t.TEST("result[0] === 'ббб'"));
+			eval(t.TEST("result.index === 3"));
+			eval(t.TEST("re.lastIndex === 6"));
+			re.lastIndex = 100;
+			return re.execAsync(str);
+		}).then(function (result) {
+			eval(t.TEST("result === null"));
+			eval(t.TEST("re.lastIndex === 0"));
+			x.done();
+		});
+	},
+	function test_execAsyncBuffer(t) {
+		"use strict";
+
+		var x = t.startAsync("test_execAsyncBuffer");
+
+		new RE2("в(г)").execAsync(new Buffer("абвгд")).then(function (result) {
+			eval(t.TEST("result[0] instanceof Buffer"));
+			eval(t.TEST("result[1].toString() === 'г'"));
+			eval(t.TEST("result.index === 4"));
+			x.done();
+		});
+	},
+	function test_execAsyncEmpty(t) {
+		"use strict";
+
+		var x = t.startAsync("test_execAsyncEmpty");
+
+		var re = new RE2("a*");
+		Promise.all([
+			re.execAsync(new Buffer(0)),
+			re.testAsync(new Buffer(0)),
+			re.matchAllAsync(new Buffer(0)),
+			re.replaceAsync(new Buffer(0), new Buffer(0))
+		]).then(function (results) {
+			eval(t.TEST("results[0][0].length === 0"));
+			eval(t.TEST("results[1] === true"));
+			eval(t.TEST("results[2].length === 1"));
+			eval(t.TEST("results[3].length === 0"));
+			x.done();
+		});
+	},
+	function test_testAsync(t) {
+		"use strict";
+
+		var x = t.startAsync("test_testAsync");
+
+		var re = new RE2("a+", "y");
+		Promise.all([new RE2("b").testAsync("abc"), new RE2("d").testAsync("abc")]).then(function (results) {
+			eval(t.TEST("t.unify(results, [true, false])"));
+			return re.testAsync("aab");
+		}).then(function (result) {
+			eval(t.TEST("result"));
+			eval(t.TEST("re.lastIndex === 2"));
+			return re.testAsync("aab");
+		}).then(function (result) {
+			eval(t.TEST("!result"));
+			eval(t.TEST("re.lastIndex === 0"));
+			x.done();
+		});
+	},
+	function test_matchAllAsync(t) {
+		"use strict";
+
+		var x = t.startAsync("test_matchAllAsync");
+
+		var re = new RE2("(\\w)(\\d)?", "g");
+		re.matchAllAsync("a1 b c3").then(function (results) {
+			eval(t.TEST("results.length === 3"));
+			eval(t.TEST("t.unify(results[0], ['a1', 'a', '1'])"));
+			eval(t.TEST("results[1][0] === 'b' && results[1][2] === undefined"));
+			eval(t.TEST("results[2].index === 5"));
+			eval(t.TEST("re.lastIndex === 0"));
+			return new RE2("x*").matchAllAsync("😀x");
+		}).then(function (results) {
+			eval(t.TEST("results.length === 3"));
+			eval(t.TEST("t.unify(results.map(function (r) { return r.index; }), [0, 2, 3])"));
+			x.done();
+		});
+	},
+	function test_replaceAsync(t) {
+		"use strict";
+
+		var x = t.startAsync("test_replaceAsync");
+
+		var long = new Array(10001).join("abc ");
+		Promise.all([
+			new RE2("(\\w+)@(\\w+)").replaceAsync("me@home", "$2:$1"),
+			new RE2("б", "g").replaceAsync(new Buffer("абаб"), "$&$&"),
+			new RE2("b", "g").replaceAsync(long, "x")
+		]).then(function (results) {
+			eval(t.TEST("results[0] === 'home:me'"));
+			eval(t.TEST("results[1] instanceof Buffer"));
+			eval(t.TEST("results[1].toString() === 'аббабб'"));
+			eval(t.TEST("results[2] === long.replace(/b/g, 'x')"));
+			return new RE2("a").replaceAsync("abc", function () { return "x"; });
+		}).then(function () {
+			t.test(false); // shouldn't be here
+			x.done();
+		}, function (error) {
+			eval(t.TEST("error instanceof TypeError"));
+			x.done();
+		});
+	}
+]);
@@ -0,0 +1,102 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// tests
+
+unit.add(module, [
+	function test_cacheHits(t) {
+		"use strict";
+
+		var before = RE2.getCacheStats();
+		eval(t.TEST("typeof before.hits == 'number'"));
+		eval(t.TEST("before.capacity === RE2.cacheCapacity"));
+
+		var re1 = new RE2("cache-(\\d+)-hits", "g");
+		var middle = RE2.getCacheStats();
+		var re2 = new RE2("cache-(\\d+)-hits", "g");
+		var after = RE2.getCacheStats();
+
+		eval(t.TEST("after.hits === middle.hits + 1"));
+		eval(t.TEST("after.misses === middle.misses"));
+
+		// objects share a program, but not a state
+		re1.exec("cache-1-hits cache-2-hits");
+		eval(t.TEST("re1.lastIndex === 12"));
+		eval(t.TEST("re2.lastIndex === 0"));
+		eval(t.TEST("re2.exec('cache-3-hits')[1] === '3'"));
+	},
+	function test_cacheKeys(t) {
+		"use strict";
+
+		var before = RE2.getCacheStats();
+		var re1 = new RE2("cache-keys");
+		var re2 = new RE2("cache-keys", "i");
+		var re3 = new RE2("cache-keys", "m");
+		var after = RE2.getCacheStats();
+
+		eval(t.TEST("after.misses === before.misses + 3"));
+		eval(t.TEST("!re1.test('CACHE-KEYS')"));
+		eval(t.TEST("re2.test('CACHE-KEYS')"));
+		eval(t.TEST("!re3.test('CACHE-KEYS')"));
+	},
+	function test_cacheInvalid(t) {
+		"use strict";
+
+		var before = RE2.getCacheStats();
+		for (var i = 0; i < 2; ++i) {
+			try {
+				var re = new RE2("cache-(invalid");
+				t.test(false); // shouldn't be here
+			} catch(e) {
+				eval(t.TEST("e instanceof SyntaxError"));
+			}
+		}
+		var after = RE2.getCacheStats();
+
+		eval(t.TEST("after.misses === before.misses + 2"));
+		eval(t.TEST("after.size === before.size"));
+	},
+	function test_cacheCapacity(t) {
+		"use strict";
+
+		var capacity = RE2.cacheCapacity;
+
+		RE2.clearCache();
+		eval(t.TEST("RE2.getCacheStats().size === 0"));
+
+		RE2.cacheCapacity = 2;
+		var before = RE2.getCacheStats();
+		new RE2("cache-a");
+		new RE2("cache-b");
+		new RE2("cache-a"); // cache-a is the most recent now
+		new RE2("cache-c"); // evicts cache-b
+		var after = RE2.getCacheStats();
+
+		eval(t.TEST("after.size === 2"));
+		eval(t.TEST("after.evictions === before.evictions + 1"));
+
+		new RE2("cache-a");
+		eval(t.TEST("RE2.getCacheStats().hits === after.hits + 1"));
+		new RE2("cache-b");
+		eval(t.TEST("RE2.getCacheStats().misses === after.misses + 1"));
+
+		RE2.cacheCapacity = 0;
+		eval(t.TEST("RE2.getCacheStats().size === 0"));
+		new RE2("cache-a");
+		eval(t.TEST("RE2.getCacheStats().size === 0"));
+
+		try {
+			RE2.cacheCapacity = -1;
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof RangeError"));
+		}
+
+		RE2.cacheCapacity = capacity;
+		eval(t.TEST("RE2.cacheCapacity === capacity"));
+	}
+]);
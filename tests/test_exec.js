@@ -281,5 +281,87 @@ unit.add(module, [
 		eval(t.TEST("t.unify(result2, [' '])"));
 		eval(t.TEST("result2.index === 5"));
 		eval(t.TEST("re2.lastIndex === 6"));
+	},
+
+	function test_execSurrogatePairs(t) {
+		"use strict";
+
+		var re = new RE2("[ab]", "g"), str = "\ud83d\ude00a\ud83d\ude00b";
+
+		var result = re.exec(str);
+		eval(t.TEST("result[0] === 'a'"));
+		eval(t.TEST("result.index === 2"));
+		eval(t.TEST("re.lastIndex === 3"));
+
+		result = re.exec(str);
+		eval(t.TEST("result[0] === 'b'"));
+		eval(t.TEST("result.index === 5"));
+		eval(t.TEST("re.lastIndex === 6"));
+	},
+
+	// Long input tests
+
+	function test_execLongGlobal(t) {
+		"use strict";
+
+		var str = new Array(200).join("Кошка cat, ");
+
+		var re = new RE2("(\\S+),", "g"), count = 0, result, lastIndex = 0;
+
+		while ((result = re.exec(str))) {
+			eval(t.TEST("result[1] === 'cat'"));
+			eval(t.TEST("result.index === str.indexOf('cat', lastIndex)"));
+			lastIndex = re.lastIndex;
+			++count;
+		}
+
+		eval(t.TEST("count === 199"));
+		eval(t.TEST("lastIndex === str.length - 1"));
+
+		var other = str.replace(/cat/g, "dog");
+
+		result = re.exec(other);
+		eval(t.TEST("result[1] === 'dog'"));
+		result = re.exec(str);
+		eval(t.TEST("result[1] === 'cat'"));
+	},
+	function test_execOneByte(t) {
+		"use strict";
+
+		// Latin-1 strings are one-byte strings in V8, but their non-ASCII characters take two bytes in UTF-8
+		var re = new RE2("(é+)(\\w)", "g"), str = "café? caféés!";
+
+		var result = re.exec(str);
+		eval(t.TEST("result.index === 9"));
+		eval(t.TEST("result[1] === 'éé'"));
+		eval(t.TEST("re.lastIndex === 12"));
+
+		re = new RE2("é(s)", "g");
+		result = re.exec(str);
+		eval(t.TEST("result.index === 10"));
+		eval(t.TEST("re.lastIndex === 12"));
+
+		// long strings take another path
+		var long = new Array(300).join("x") + str;
+		re.lastIndex = 0;
+		result = re.exec(long);
+		eval(t.TEST("result.index === 299 + 10"));
+		eval(t.TEST("re.lastIndex === 299 + 12"));
+	},
+	function test_execExternalString(t) {
+		"use strict";
+
+		// large strings decoded from buffers are external in V8: ASCII ones are matched in place
+		var buffer = Buffer.alloc(2 * 1024 * 1024, "a");
+		buffer.write("needle-42", 1500000);
+		var str = buffer.toString("latin1"), re = new RE2("needle-(\\d+)", "g");
+
+		var result = re.exec(str);
+		eval(t.TEST("result.index === 1500000"));
+		eval(t.TEST("result[1] === '42'"));
+		eval(t.TEST("re.lastIndex === 1500009"));
+		eval(t.TEST("re.exec(str) === null"));
+
+		eval(t.TEST("new RE2('^a+$').test(str.slice(0, 1000000))"));
 	}
 ]);
@@ -0,0 +1,71 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// tests
+
+unit.add(module, [
+	function test_execInto(t) {
+		"use strict";
+
+		var re = new RE2("(\\d+)-(\\d+)?"), spans = new Int32Array(6);
+
+		eval(t.TEST("re.execInto('ab 12-34', spans) === 3"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(spans), [3, 8, 3, 5, 6, 8])"));
+
+		eval(t.TEST("re.execInto('ab 12-', spans) === 3"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(spans), [3, 6, 3, 5, -1, -1])"));
+
+		eval(t.TEST("re.execInto('nothing', spans) === -1"));
+	},
+	function test_execIntoShort(t) {
+		"use strict";
+
+		var re = new RE2("(\\d+)-(\\d+)"), spans = new Int32Array(2);
+
+		eval(t.TEST("re.execInto('ab 12-34', spans) === 1"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(spans), [3, 8])"));
+
+		eval(t.TEST("re.execInto('ab 12-34', new Int32Array(0)) === 0"));
+		eval(t.TEST("re.execInto('ab', new Int32Array(0)) === -1"));
+	},
+	function test_execIntoUnicode(t) {
+		"use strict";
+
+		var re = new RE2("в(г)"), spans = new Int32Array(4);
+
+		eval(t.TEST("re.execInto('😀абвгд', spans) === 2"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(spans), [4, 6, 5, 6])"));
+
+		eval(t.TEST("re.execInto(new Buffer('абвгд'), spans) === 2"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(spans), [4, 8, 6, 8])"));
+	},
+	function test_execIntoGlobal(t) {
+		"use strict";
+
+		var re = new RE2("\\d+", "g"), spans = new Int32Array(2), str = "1 22 333", found = [];
+
+		while (re.execInto(str, spans) >= 0) {
+			found.push(spans[0], spans[1]);
+		}
+		eval(t.TEST("t.unify(found, [0, 1, 2, 4, 5, 8])"));
+		eval(t.TEST("re.lastIndex === 0"));
+
+		var sticky = new RE2("a", "y");
+		eval(t.TEST("sticky.execInto('aab', new Int32Array(0)) === 0"));
+		eval(t.TEST("sticky.lastIndex === 1"));
+	},
+	function test_execIntoInvalid(t) {
+		"use strict";
+
+		try {
+			new RE2("a").execInto("a", [0, 0]);
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+	}
+]);
@@ -0,0 +1,61 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// tests
+
+unit.add(module, [
+	function test_execLazy(t) {
+		"use strict";
+
+		var re = new RE2("(\\d+)-(\\d+)?"), result = re.execLazy("ab 12-");
+
+		eval(t.TEST("result.length === 3"));
+		eval(t.TEST("result[0] === '12-'"));
+		eval(t.TEST("result[1] === '12'"));
+		eval(t.TEST("result[2] === undefined"));
+		eval(t.TEST("!(2 in result)"));
+		eval(t.TEST("result.index === 3"));
+		eval(t.TEST("result.input === 'ab 12-'"));
+		eval(t.TEST("result.groups === undefined"));
+		eval(t.TEST("Array.prototype.slice.call(result, 0, 2).join('|') === '12-|12'"));
+		eval(t.TEST("result.join('|') === '12-|12|'"));
+
+		eval(t.TEST("re.execLazy('nothing') === null"));
+	},
+	function test_execLazyGroups(t) {
+		"use strict";
+
+		var re = new RE2("(?P<a>\\w)(?P<b>\\d)?"), result = re.execLazy("😀x");
+
+		eval(t.TEST("result.index === 2"));
+		eval(t.TEST("result.groups.a === 'x'"));
+		eval(t.TEST("result.groups.b === undefined"));
+		eval(t.TEST("result.groups === result.groups"));
+		eval(t.TEST("t.unify(Object.keys(result.groups), ['a', 'b'])"));
+		eval(t.TEST("result[1] === result.groups.a"));
+	},
+	function test_execLazyBuffer(t) {
+		"use strict";
+
+		var result = new RE2("в(г)").execLazy(new Buffer("абвгд"));
+
+		eval(t.TEST("result[0] instanceof Buffer"));
+		eval(t.TEST("result[1].toString() === 'г'"));
+		eval(t.TEST("result.index === 4"));
+	},
+	function test_execLazyGlobal(t) {
+		"use strict";
+
+		var re = new RE2("\\d+", "g"), found = [], result;
+
+		while ((result = re.execLazy("1 22 333"))) {
+			found.push(result[0]);
+		}
+		eval(t.TEST("t.unify(found, ['1', '22', '333'])"));
+		eval(t.TEST("re.lastIndex === 0"));
+	}
+]);
@@ -0,0 +1,79 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// tests
+
+unit.add(module, [
+	function test_filteredSetMatch(t) {
+		"use strict";
+
+		var set = new RE2.FilteredSet(["hello\\s+world", "foo|bar", "abc\\d+xyz", "\\d+"]);
+
+		eval(t.TEST("set.size === 4"));
+		eval(t.TEST("set.flags === 'u'"));
+		eval(t.TEST("set.atoms.length > 0"));
+
+		eval(t.TEST("t.unify(set.match('hello   world'), [0])"));
+		eval(t.TEST("t.unify(set.match('xx abc12xyz'), [2, 3])"));
+		eval(t.TEST("t.unify(set.match('a bar'), [1])"));
+		eval(t.TEST("t.unify(set.match('nothing'), [])"));
+
+		eval(t.TEST("set.test('foo')"));
+		eval(t.TEST("!set.test('baz')"));
+	},
+	function test_filteredSetEvaluated(t) {
+		"use strict";
+
+		var set = new RE2.FilteredSet(["alpha\\d", "beta\\d", "gamma\\d", "[a-z]+\\d"]);
+
+		eval(t.TEST("t.unify(set.match('beta1'), [1, 3])"));
+		// only rules with matching atoms, and rules without atoms are evaluated
+		eval(t.TEST("set.lastEvaluated === 2"));
+
+		eval(t.TEST("t.unify(set.match('delta1'), [3])"));
+		eval(t.TEST("set.lastEvaluated === 1"));
+	},
+	function test_filteredSetBuffer(t) {
+		"use strict";
+
+		var set = RE2.FilteredSet(["привет", "мир"]);
+
+		eval(t.TEST("t.unify(set.match(new Buffer('привет, мир')), [0, 1])"));
+		eval(t.TEST("t.unify(set.match('ПРИВЕТ'), [])"));
+
+		set = RE2.FilteredSet(["привет", "мир"], "i");
+
+		eval(t.TEST("set.flags === 'iu'"));
+		eval(t.TEST("t.unify(set.match('ПРИВЕТ'), [0])"));
+	},
+	function test_filteredSetEmpty(t) {
+		"use strict";
+
+		var set = new RE2.FilteredSet([]);
+
+		eval(t.TEST("set.size === 0"));
+		eval(t.TEST("t.unify(set.match('abc'), [])"));
+		eval(t.TEST("!set.test('abc')"));
+	},
+	function test_filteredSetInvalid(t) {
+		"use strict";
+
+		try {
+			var set = new RE2.FilteredSet(["abc", "(abc"]);
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof SyntaxError"));
+		}
+
+		try {
+			var set = new RE2.FilteredSet([1]);
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+	}
+]);
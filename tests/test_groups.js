@@ -94,5 +94,18 @@ unit.add(module, [
 		} catch(e) {
 			eval(t.TEST("e instanceof SyntaxError"));
 		}
+	},
+	function test_groupsShape(t) {
+		"use strict";
+
+		var re = new RE2('(?<year>\\d{4})-(?<month>\\d{2})(?:-(?<day>\\d{2}))?'),
+			a = re.exec('2017-01-02'), b = re.exec('2018-03');
+
+		eval(t.TEST("t.unify(Object.keys(a.groups), ['year', 'month', 'day'])"));
+		eval(t.TEST("t.unify(Object.keys(b.groups), ['year', 'month', 'day'])"));
+		eval(t.TEST("b.groups.day === undefined"));
+		eval(t.TEST("b.length === 4"));
+		eval(t.TEST("Object.getPrototypeOf(b.groups) === null"));
+		eval(t.TEST("t.unify(Object.keys(a).slice(4), Object.keys(b).slice(3))"));
 	}
 ]);
@@ -0,0 +1,74 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// tests
+
+unit.add(module, [
+	function test_testMany(t) {
+		"use strict";
+
+		var re = new RE2("b+");
+
+		var result = re.testMany(["abc", "xyz", new Buffer("bbb"), ""]);
+		eval(t.TEST("result instanceof Uint8Array"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result), [1, 0, 1, 0])"));
+
+		eval(t.TEST("re.testMany([]).length === 0"));
+	},
+	function test_searchMany(t) {
+		"use strict";
+
+		var re = new RE2("в");
+
+		var result = re.searchMany(["абв", "в", "😀в", "abc", new Buffer("абв")]);
+		eval(t.TEST("result instanceof Int32Array"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result), [2, 0, 2, -1, 4])"));
+
+		eval(t.TEST("t.unify(Array.prototype.slice.call(new RE2('^b', 'y').searchMany(['ab', 'ba'])), [-1, 0])"));
+	},
+	function test_execMany(t) {
+		"use strict";
+
+		var re = new RE2("(\\d+)(x)?");
+
+		var result = re.execMany(["a12", "none", "б3x"]);
+		eval(t.TEST("result instanceof Int32Array"));
+		eval(t.TEST("result.length === 18"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result, 0, 6), [1, 3, 1, 3, -1, -1])"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result, 6, 12), [-1, -1, -1, -1, -1, -1])"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result, 12), [1, 3, 1, 2, 2, 3])"));
+	},
+	function test_manyBufferOffsets(t) {
+		"use strict";
+
+		var buf = new Buffer("one\ntwo 2\nthree 33\n"), offsets = new Int32Array([0, 4, 10, 19]);
+
+		var re = new RE2("\\d+");
+		eval(t.TEST("t.unify(Array.prototype.slice.call(re.testMany(buf, offsets)), [0, 1, 1])"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(re.searchMany(buf, offsets)), [-1, 4, 6])"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(re.execMany(buf, offsets)), [-1, -1, 4, 5, 6, 8])"));
+	},
+	function test_manyInvalid(t) {
+		"use strict";
+
+		var re = new RE2("a");
+
+		try {
+			re.testMany("abc");
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+
+		try {
+			re.testMany(new Buffer("abc"), new Int32Array([0, 5]));
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof RangeError"));
+		}
+	}
+]);
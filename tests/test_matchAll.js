@@ -0,0 +1,94 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// tests
+
+unit.add(module, [
+	function test_matchAll(t) {
+		"use strict";
+
+		var re = new RE2("(\\w)(\\d)?", "g"), it = re.matchAll("a1 b c3"), item;
+
+		item = it.next();
+		eval(t.TEST("!item.done"));
+		eval(t.TEST("t.unify(item.value, ['a1', 'a', '1'])"));
+		eval(t.TEST("item.value.index === 0"));
+		eval(t.TEST("item.value.input === 'a1 b c3'"));
+
+		item = it.next();
+		eval(t.TEST("item.value[0] === 'b' && item.value[1] === 'b' && item.value[2] === undefined"));
+		eval(t.TEST("item.value.index === 3"));
+
+		item = it.next();
+		eval(t.TEST("t.unify(item.value, ['c3', 'c', '3'])"));
+		eval(t.TEST("item.value.index === 5"));
+
+		item = it.next();
+		eval(t.TEST("item.done && item.value === undefined"));
+		eval(t.TEST("it.next().done"));
+
+		eval(t.TEST("re.lastIndex === 0"));
+	},
+	function test_matchAllIterable(t) {
+		"use strict";
+
+		if (typeof Symbol == "undefined" || !Symbol.iterator) return;
+
+		var re = new RE2("(?P<d>\\d+)", "g"), indices = [], names = [];
+		var it = re.matchAll("1 😀22 333");
+		eval(t.TEST("it[Symbol.iterator]() === it"));
+
+		var item;
+		while (!(item = it.next()).done) {
+			indices.push(item.value.index);
+			names.push(item.value.groups.d);
+		}
+		eval(t.TEST("t.unify(indices, [0, 4, 7])"));
+		eval(t.TEST("t.unify(names, ['1', '22', '333'])"));
+	},
+	function test_matchAllEmpty(t) {
+		"use strict";
+
+		var it = new RE2("x*", "g").matchAll("😀x"), indices = [], item;
+		while (!(item = it.next()).done) {
+			indices.push(item.value.index);
+		}
+		eval(t.TEST("t.unify(indices, [0, 2, 3])"));
+	},
+	function test_matchAllBuffer(t) {
+		"use strict";
+
+		var it = new RE2("б", "g").matchAll(new Buffer("абаб")), item;
+
+		item = it.next();
+		eval(t.TEST("item.value[0] instanceof Buffer"));
+		eval(t.TEST("item.value.index === 2"));
+		item = it.next();
+		eval(t.TEST("item.value.index === 6"));
+		eval(t.TEST("it.next().done"));
+	},
+	function test_matchAllLastIndex(t) {
+		"use strict";
+
+		var re = new RE2("\\d", "g");
+		re.lastIndex = 2;
+
+		var it = re.matchAll("1234"), item = it.next();
+		eval(t.TEST("item.value[0] === '3'"));
+		eval(t.TEST("re.lastIndex === 2"));
+	},
+	function test_matchAllInvalid(t) {
+		"use strict";
+
+		try {
+			new RE2("a").matchAll("a");
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+	}
+]);
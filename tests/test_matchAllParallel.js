@@ -0,0 +1,97 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// helpers
+
+function sequential(re, buffer) {
+	var spans = [], iterator = new RE2(re, "g" + re.flags).matchAll(buffer);
+	for (var item = iterator.next(); !item.done; item = iterator.next()) {
+		spans.push(item.value.index, item.value[0].length);
+	}
+	return spans;
+}
+
+function makeLog(lines) {
+	var text = [];
+	for (var i = 0; i < lines; ++i) {
+		text.push("line " + i + (i % 7 ? " ok" : " ERROR code=" + i) + (i % 5 ? "" : " ошибка"));
+	}
+	return new Buffer(text.join("\n"));
+}
+
+
+// tests
+
+unit.add(module, [
+	function test_matchAllParallelRecords(t) {
+		"use strict";
+
+		var buffer = makeLog(5000), re = new RE2("ERROR code=\\d+");
+		var expected = sequential(re, buffer);
+
+		var result = re.matchAllParallel(buffer, {threads: 4, minSize: 0});
+		eval(t.TEST("result.spans instanceof Float64Array"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result.spans), expected)"));
+		eval(t.TEST("result.threads === 4"));
+		eval(t.TEST("result.pieces >= 4"));
+		eval(t.TEST("typeof result.time == 'number'"));
+		eval(t.TEST("result.efficiency > 0 && result.efficiency <= 1"));
+	},
+	function test_matchAllParallelOverlap(t) {
+		"use strict";
+
+		var buffer = makeLog(3000);
+
+		// matches cross line boundaries, so pieces overlap
+		["ok\\nline", "\\d+\\s+\\w+", "ош", "^line", "a*", "(?:ok|ERROR)[^\\n]*\\n[^\\n]*"].forEach(function (pattern) {
+			var re = new RE2(pattern, "m"), expected = sequential(re, buffer);
+			for (var threads = 2; threads <= 8; threads *= 2) {
+				var result = re.matchAllParallel(buffer, {threads: threads, minSize: 0, maxMatchLength: 64});
+				eval(t.TEST("t.unify(Array.prototype.slice.call(result.spans), expected)"));
+			}
+		});
+	},
+	function test_matchAllParallelSmall(t) {
+		"use strict";
+
+		// small inputs are scanned sequentially
+		var re = new RE2("b+"), result = re.matchAllParallel(new Buffer("abbcb"), {threads: 8});
+		eval(t.TEST("result.threads === 1"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result.spans), [1, 2, 4, 1])"));
+
+		result = re.matchAllParallel(new Buffer(""), {threads: 8, minSize: 0});
+		eval(t.TEST("result.spans.length === 0"));
+		result = new RE2("").matchAllParallel(new Buffer(""), {threads: 8, minSize: 0});
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result.spans), [0, 0])"));
+
+		result = new RE2(";").matchAllParallel(new Buffer("a;b;c;d"), {threads: 3, minSize: 0, separator: ";"});
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result.spans), [1, 1, 3, 1, 5, 1])"));
+	},
+	function test_matchAllParallelErrors(t) {
+		"use strict";
+
+		var re = new RE2("a");
+		try {
+			re.matchAllParallel("abc");
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+		try {
+			re.matchAllParallel(new Buffer("abc"), {threads: 0});
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof RangeError"));
+		}
+		try {
+			re.matchAllParallel(new Buffer("abc"), {separator: "ab"});
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+	}
+]);
@@ -61,5 +61,33 @@ unit.add(module, [
 		}
 
 		RE2.unicodeWarningLevel = "nothing";
+	},
+	function test_newClone(t) {
+		"use strict";
+
+		var re = new RE2("a(b+)c", "u");
+		var stats = RE2.getCacheStats();
+
+		var g = new RE2(re, "gu");
+		var y = new RE2(re, "yu");
+		var same = new RE2(re);
+
+		// only global and sticky flags differ: no compilation, no cache lookups
+		var after = RE2.getCacheStats();
+		eval(t.TEST("after.hits === stats.hits && after.misses === stats.misses"));
+
+		eval(t.TEST("g.flags === 'gu' && y.flags === 'uy' && same.flags === 'u'"));
+		eval(t.TEST("g.source === re.source && y.source === re.source"));
+
+		g.exec("abbc abc");
+		eval(t.TEST("g.lastIndex === 4"));
+		eval(t.TEST("re.lastIndex === 0 && y.lastIndex === 0"));
+		eval(t.TEST("y.exec('xabc') === null"));
+		eval(t.TEST("y.exec('abbbc')[1] === 'bbb'"));
+
+		// other flags require a different program
+		var i = new RE2(re, "iu");
+		eval(t.TEST("i.flags === 'iu'"));
+		eval(t.TEST("i.test('ABC') && !re.test('ABC')"));
 	}
 ]);
@@ -0,0 +1,80 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// tests
+
+unit.add(module, [
+	function test_optionsMaxMem(t) {
+		"use strict";
+
+		var re = new RE2("a+b");
+		eval(t.TEST("re.maxMem === 8 << 20"));
+		eval(t.TEST("re.programSize > 0"));
+		eval(t.TEST("re.reverseProgramSize > 0"));
+
+		var small = new RE2("a+b", {maxMem: 1 << 20});
+		eval(t.TEST("small.maxMem === 1 << 20"));
+		eval(t.TEST("small.test('xaab')"));
+
+		var flagged = new RE2("a+b", "gi", {maxMem: 2 << 20});
+		eval(t.TEST("flagged.maxMem === 2 << 20"));
+		eval(t.TEST("flagged.flags === 'giu'"));
+		eval(t.TEST("flagged.test('AB')"));
+
+		// clones keep options of their originals
+		var clone = new RE2(small, "g");
+		eval(t.TEST("clone.maxMem === 1 << 20"));
+		clone = new RE2(small, "i");
+		eval(t.TEST("clone.maxMem === 1 << 20"));
+		clone = new RE2(small, "", {maxMem: 4 << 20});
+		eval(t.TEST("clone.maxMem === 4 << 20"));
+
+		try {
+			var bad = new RE2("a", {maxMem: -1});
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof RangeError"));
+		}
+		try {
+			var bad = new RE2("a", "", 42);
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+	},
+	function test_optionsFlags(t) {
+		"use strict";
+
+		var re = new RE2("a.c", {literal: true});
+		eval(t.TEST("!re.test('abc')"));
+		eval(t.TEST("re.test('xa.cx')"));
+
+		re = new RE2("a/b", {literal: true});
+		eval(t.TEST("re.test('a/b')"));
+
+		re = new RE2("a.c", {dotNL: true});
+		eval(t.TEST("re.test('a\\nc')"));
+		eval(t.TEST("!new RE2('a.c').test('a\\nc')"));
+
+		re = new RE2("a|ab", {longestMatch: true});
+		eval(t.TEST("re.exec('ab')[0] === 'ab'"));
+		eval(t.TEST("new RE2('a|ab').exec('ab')[0] === 'a'"));
+
+		re = new RE2("a\\nc", {neverNL: true});
+		eval(t.TEST("!re.test('a\\nc')"));
+		eval(t.TEST("new RE2('a\\nc').test('a\\nc')"));
+
+		re = new RE2("a[[:digit:]]", {posixSyntax: true});
+		eval(t.TEST("re.test('a1')"));
+		try {
+			re = new RE2("a\\d", {posixSyntax: true});
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof SyntaxError"));
+		}
+	}
+]);
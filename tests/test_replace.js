@@ -229,5 +229,125 @@ unit.add(module, [
 
 		eval(t.TEST("re2.replace('ABCDEFABCDEF', '!') === '!!!!!FABCDEF'"));
 		eval(t.TEST("re2.lastIndex === 0"));
+	},
+
+	// Replacement templates
+
+	function test_replaceTemplateReuse(t) {
+		"use strict";
+
+		var re = new RE2("(\\w)(\\d)", "g");
+
+		eval(t.TEST("re.replace('a1 b2', '$2$1') === '1a 2b'"));
+		eval(t.TEST("re.replace('c3 d4', '$2$1') === '3c 4d'"));
+		eval(t.TEST("re.replace('c3 d4', '[$&]') === '[c3] [d4]'"));
+		eval(t.TEST("re.replace('c3 d4', '$2$1') === '3c 4d'"));
+	},
+	function test_replaceTemplateSpecial(t) {
+		"use strict";
+
+		var re = new RE2("(a)(b)(c)(d)(e)(f)(g)(h)(i)(j)(k)(l)");
+
+		eval(t.TEST("re.replace('-abcdefghijkl-', '$<$12') === '-$<l-'"));
+		eval(t.TEST("re.replace('-abcdefghijkl-', '$13|$0|$$') === '-$13|$0|$-'"));
+		eval(t.TEST("re.replace('-abcdefghijkl-', '$`$\\'') === '----'"));
+	},
+	function test_replaceLongResults(t) {
+		"use strict";
+
+		var str = new Array(2001).join("ab "), re = new RE2("b", "g");
+
+		var result = re.replace(str, "c");
+		eval(t.TEST("typeof result == 'string'"));
+		eval(t.TEST("result === str.replace(/b/g, 'c')"));
+		eval(t.TEST("result.length === 6000"));
+
+		result = re.replace(str + "б", "c");
+		eval(t.TEST("result === str.replace(/b/g, 'c') + 'б'"));
+
+		result = re.replace(new Buffer(str), "c");
+		eval(t.TEST("result instanceof Buffer"));
+		eval(t.TEST("result.toString() === str.replace(/b/g, 'c')"));
+
+		eval(t.TEST("new RE2('x').replace(new Buffer(''), 'y').length === 0"));
+	},
+
+	// Batched replacers
+
+	function test_replaceBatch(t) {
+		"use strict";
+
+		var calls = 0;
+		function replacer(spans, input, stride) {
+			++calls;
+			var result = [];
+			for (var i = 0; i < spans.length; i += 2 * stride) {
+				result.push("<" + input.slice(spans[i + 2], spans[i + 3]) + ">");
+			}
+			return result;
+		}
+		replacer.useBatch = true;
+
+		var re = new RE2("(\\d+)(x)?", "g");
+		eval(t.TEST("re.replace('a1 b22x c333', replacer) === 'a<1> b<22> c<333>'"));
+		eval(t.TEST("calls === 1"));
+
+		eval(t.TEST("re.replace('no digits', replacer) === 'no digits'"));
+		eval(t.TEST("calls === 1"));
+
+		eval(t.TEST("new RE2('б(в)?').replace('абвгб', replacer) === 'а<в>гб'"));
+	},
+	function test_replaceBatchSpans(t) {
+		"use strict";
+
+		var seen;
+		function replacer(spans, input, stride) {
+			seen = Array.prototype.slice.call(spans);
+			return ["!", "!"];
+		}
+		replacer.useBatch = true;
+
+		var re = new RE2("(a)|(б)", "g");
+		eval(t.TEST("re.replace('😀aб', replacer) === '😀!!'"));
+		eval(t.TEST("t.unify(seen, [2, 3, 2, 3, -1, -1, 3, 4, -1, -1, 3, 4])"));
+
+		replacer.useBuffers = true;
+		eval(t.TEST("re.replace('😀aб', replacer) === '😀!!'"));
+		eval(t.TEST("t.unify(seen, [4, 5, 4, 5, -1, -1, 5, 7, -1, -1, 5, 7])"));
+
+		var bufResult = re.replace(new Buffer('😀aб'), replacer);
+		eval(t.TEST("bufResult instanceof Buffer"));
+		eval(t.TEST("bufResult.toString() === '😀!!'"));
+	},
+	function test_replaceBatchInvalid(t) {
+		"use strict";
+
+		function replacer() { return null; }
+		replacer.useBatch = true;
+
+		try {
+			new RE2("a").replace("abc", replacer);
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+	},
+	function test_replaceBatchThrowingPart(t) {
+		"use strict";
+
+		var calls = 0;
+		function replacer(spans) {
+			++calls;
+			return ["x", {toString: function () { throw new Error("toString"); }}];
+		}
+		replacer.useBatch = true;
+
+		try {
+			new RE2("a", "g").replace("aba", replacer);
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e.message === 'toString'"));
+		}
+		eval(t.TEST("calls === 1"));
 	}
 ]);
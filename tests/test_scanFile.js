@@ -0,0 +1,100 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+var fs   = require("fs");
+var os   = require("os");
+var path = require("path");
+
+
+// helpers
+
+function makeFile(name, content) {
+	var fileName = path.join(os.tmpdir(), "re2-test-" + process.pid + "-" + name);
+	fs.writeFileSync(fileName, content);
+	return fileName;
+}
+
+
+// tests
+
+unit.add(module, [
+	function test_scanFileSpans(t) {
+		"use strict";
+
+		var fileName = makeFile("spans.txt", "one 12\nдва 345\n\nfour 6\n");
+
+		var result = RE2.scanFile(fileName, new RE2("\\d+"));
+		eval(t.TEST("result instanceof Float64Array"));
+		// offsets and lengths are in bytes
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result), [4, 2, 14, 3, 24, 1])"));
+
+		result = RE2.scanFile(fileName, new RE2("\\d+"), {maxMatches: 2});
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result), [4, 2, 14, 3])"));
+
+		result = RE2.scanFile(fileName, new RE2("x"));
+		eval(t.TEST("result.length === 0"));
+
+		fs.unlinkSync(fileName);
+	},
+	function test_scanFileLines(t) {
+		"use strict";
+
+		var fileName = makeFile("lines.txt", "a\nb a a\n\na");
+
+		var result = RE2.scanFile(fileName, new RE2("a"), {lines: true});
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result), [1, 2, 4])"));
+
+		result = RE2.scanFile(fileName, new RE2("^$", "m"), {lines: true});
+		eval(t.TEST("t.unify(Array.prototype.slice.call(result), [3])"));
+
+		fs.unlinkSync(fileName);
+	},
+	function test_scanFileEmpty(t) {
+		"use strict";
+
+		var fileName = makeFile("empty.txt", "");
+
+		eval(t.TEST("RE2.scanFile(fileName, new RE2('a')).length === 0"));
+		eval(t.TEST("t.unify(Array.prototype.slice.call(RE2.scanFile(fileName, new RE2(''))), [0, 0])"));
+
+		fs.unlinkSync(fileName);
+	},
+	function test_scanFileErrors(t) {
+		"use strict";
+
+		try {
+			RE2.scanFile(path.join(os.tmpdir(), "re2-test-does-not-exist"), new RE2("a"));
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof Error"));
+		}
+		try {
+			RE2.scanFile("file.txt", /a/);
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+	},
+	function test_scanFileAsync(t) {
+		"use strict";
+
+		var x = t.startAsync("test_scanFileAsync");
+
+		var fileName = makeFile("async.txt", "x1 x22 x333");
+
+		RE2.scanFileAsync(fileName, new RE2("x\\d+")).then(function (result) {
+			eval(t.TEST("t.unify(Array.prototype.slice.call(result), [0, 2, 3, 3, 7, 4])"));
+			fs.unlinkSync(fileName);
+			return RE2.scanFileAsync(fileName, new RE2("x"));
+		}).then(function () {
+			t.test(false); // shouldn't be here
+			x.done();
+		}, function (error) {
+			eval(t.TEST("error instanceof Error"));
+			x.done();
+		});
+	}
+]);
@@ -0,0 +1,143 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// helpers
+
+function scanAll(re, chunks, options) {
+	var scanner = re.createScanner(options), result = [];
+	chunks.forEach(function (chunk) {
+		Array.prototype.push.apply(result, scanner.write(new Buffer(chunk)));
+	});
+	Array.prototype.push.apply(result, scanner.end());
+	return result.map(function (match) { return [match.index, match[0].toString()]; });
+}
+
+function splitInto(str, size) {
+	var chunks = [];
+	for (var i = 0; i < str.length; i += size) {
+		chunks.push(str.slice(i, i + size));
+	}
+	return chunks;
+}
+
+
+// tests
+
+unit.add(module, [
+	function test_scannerChunks(t) {
+		"use strict";
+
+		var re = new RE2("\\b\\w+@\\w+\\.com\\b"), text = "mail a@b.com, or xy@zz.com; not q@r.org, and k@l.com";
+		var expected = [[5, "a@b.com"], [17, "xy@zz.com"], [45, "k@l.com"]];
+
+		eval(t.TEST("t.unify(scanAll(re, [text]), expected)"));
+		for (var size = 1; size < 12; ++size) {
+			eval(t.TEST("t.unify(scanAll(re, splitInto(text, size), {maxMatchLength: 16}), expected)"));
+		}
+	},
+	function test_scannerResults(t) {
+		"use strict";
+
+		var re = new RE2("(?<key>\\w+)=(\\d+)?");
+		var scanner = re.createScanner({maxMatchLength: 8});
+		var results = scanner.write(new Buffer("a=1 bb="));
+		results = results.concat(scanner.end(new Buffer("2 c=")));
+
+		eval(t.TEST("results.length === 3"));
+		eval(t.TEST("results[0].index === 0 && results[1].index === 4 && results[2].index === 9"));
+		eval(t.TEST("results[0][0] instanceof Buffer"));
+		eval(t.TEST("results[1][0].toString() === 'bb=2'"));
+		eval(t.TEST("results[1].groups.key.toString() === 'bb'"));
+		eval(t.TEST("results[2][2] === undefined"));
+		eval(t.TEST("scanner.offset === 11"));
+	},
+	function test_scannerAnchors(t) {
+		"use strict";
+
+		// ^ matches only at the start of a stream, and $ only at its end
+		var chunks = ["xxxx", "xxxx", "xxxx"], small = {maxMatchLength: 1};
+		eval(t.TEST("t.unify(scanAll(new RE2('^x'), chunks, small), [[0, 'x']])"));
+		eval(t.TEST("t.unify(scanAll(new RE2('x$'), chunks, small), [[11, 'x']])"));
+		eval(t.TEST("t.unify(scanAll(new RE2('^x', 'm'), ['xx\\nxx', '\\nxx\\n', 'x'], small), [[0, 'x'], [3, 'x'], [6, 'x'], [9, 'x']])"));
+		eval(t.TEST("t.unify(scanAll(new RE2(''), ['', '']), [[0, '']])"));
+	},
+	function test_scannerUnicode(t) {
+		"use strict";
+
+		// offsets are in bytes, characters can be split between chunks
+		var chunks = [new Buffer([0xD0]), new Buffer([0xB4, 0xD0, 0xB4]), new Buffer("xxxxxx")];
+		var scanner = new RE2("д+").createScanner({maxMatchLength: 4}), result = [];
+		chunks.forEach(function (chunk) { result = result.concat(scanner.write(chunk)); });
+		result = result.concat(scanner.end());
+
+		eval(t.TEST("result.length === 1"));
+		eval(t.TEST("result[0].index === 0"));
+		eval(t.TEST("result[0][0].toString() === 'дд'"));
+	},
+	function test_scannerErrors(t) {
+		"use strict";
+
+		var re = new RE2("a");
+		try {
+			re.createScanner({maxMatchLength: 0});
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof RangeError"));
+		}
+
+		var scanner = re.createScanner();
+		try {
+			scanner.write("a");
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+
+		scanner.end();
+		try {
+			scanner.write(new Buffer("a"));
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof Error"));
+		}
+	},
+	function test_scannerStream(t) {
+		"use strict";
+
+		var x = t.startAsync("test_scannerStream");
+
+		var stream = new RE2("\\d+").createScanStream({maxMatchLength: 10}), results = [];
+		stream.on("data", function (match) { results.push([match.index, match[0].toString()]); });
+		stream.on("end", function () {
+			eval(t.TEST("t.unify(results, [[1, '12'], [5, '345'], [14, '6']])"));
+			x.done();
+		});
+
+		stream.write("a12 b");
+		stream.write(new Buffer("34"));
+		stream.write("5 ця 6");
+		stream.end();
+	},
+	function test_scannerWrongObject(t) {
+		"use strict";
+
+		try {
+			RE2.prototype.createScanner.call(new RE2.Set(["a"]));
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+
+		var scanner = new RE2("a").createScanner();
+		try {
+			scanner.write.call(new RE2.Set(["a"]), new Buffer("a"));
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+	}
+]);
@@ -103,5 +103,51 @@ unit.add(module, [
 		re = new RE2("z", "gmy");
 		result = re.search(str);
 		eval(t.TEST("result === -1"));
+	},
+	function test_searchHotLoop(t) {
+		"use strict";
+
+		var re = new RE2("[éb]+"), sticky = new RE2("a", "y"), results = [];
+
+		for (var i = 0; i < 100000; ++i) {
+			if (re.search("aabba") !== 2 || re.search("caféé") !== 3 || re.search("xyz") !== -1 ||
+					sticky.search("abc") !== 0 || sticky.search("bac") !== -1) {
+				results.push(i);
+				break;
+			}
+		}
+
+		eval(t.TEST("results.length === 0"));
+	},
+	function test_searchFastCall(t) {
+		"use strict";
+
+		if (!("fastCalls" in RE2.stats())) {
+			return; // the addon is built without fast API calls
+		}
+
+		// optimize a caller explicitly, and check that V8 called the fast version
+		require("v8").setFlagsFromString("--allow-natives-syntax");
+		var prepare  = new Function("f", "%PrepareFunctionForOptimization(f);"),
+			optimize = new Function("f", "%OptimizeFunctionOnNextCall(f);");
+
+		function check(re, str) { return re.search(str); }
+
+		var re = new RE2("[éb]+");
+
+		RE2.collectStats = true;
+		prepare(check);
+		check(re, "aabba");
+		check(re, "xyz");
+		optimize(check);
+
+		var before = re.stats().fastCalls;
+		eval(t.TEST("check(re, 'aabba') === 2"));
+		eval(t.TEST("check(re, 'caféé') === 3"));
+		eval(t.TEST("check(re, 'xyz') === -1"));
+		var after = re.stats().fastCalls;
+		RE2.collectStats = false;
+
+		eval(t.TEST("after > before"));
 	}
 ]);
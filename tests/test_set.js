@@ -0,0 +1,108 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// tests
+
+unit.add(module, [
+	function test_setMatch(t) {
+		"use strict";
+
+		var set = new RE2.Set(["\\d+", "[a-z]+", "foo", "^bar$"]);
+
+		eval(t.TEST("set.size === 4"));
+		eval(t.TEST("set.flags === 'u'"));
+		eval(t.TEST("set.anchor === 'unanchored'"));
+
+		eval(t.TEST("t.unify(set.match('abc 123'), [0, 1])"));
+		eval(t.TEST("t.unify(set.match('foo'), [1, 2])"));
+		eval(t.TEST("t.unify(set.match('bar'), [1, 3])"));
+		eval(t.TEST("t.unify(set.match('  '), [])"));
+
+		eval(t.TEST("set.test('abc')"));
+		eval(t.TEST("!set.test('!!!')"));
+	},
+	function test_setBuffer(t) {
+		"use strict";
+
+		var set = RE2.Set(["б+", "в"]);
+
+		eval(t.TEST("t.unify(set.match(new Buffer('абв')), [0, 1])"));
+		eval(t.TEST("t.unify(set.match(new Buffer('аб')), [0])"));
+		eval(t.TEST("set.test(new Buffer('в'))"));
+	},
+	function test_setFlags(t) {
+		"use strict";
+
+		var set = new RE2.Set(["abc", "^x"], "im");
+
+		eval(t.TEST("set.flags === 'imu'"));
+		eval(t.TEST("t.unify(set.match('ABC\\nx'), [0, 1])"));
+	},
+	function test_setAnchor(t) {
+		"use strict";
+
+		var set = new RE2.Set(["a", "b+"], {anchor: "start"});
+
+		eval(t.TEST("set.anchor === 'start'"));
+		eval(t.TEST("t.unify(set.match('bbb'), [1])"));
+		eval(t.TEST("t.unify(set.match('cab'), [])"));
+
+		set = new RE2.Set(["a", "b+"], "", {anchor: "both"});
+
+		eval(t.TEST("set.anchor === 'both'"));
+		eval(t.TEST("t.unify(set.match('bbb'), [1])"));
+		eval(t.TEST("t.unify(set.match('bbba'), [])"));
+	},
+	function test_setSources(t) {
+		"use strict";
+
+		var set = new RE2.Set([/a\/b/, new RE2("c+"), new Buffer("d"), "(?<x>e)"]);
+
+		eval(t.TEST("t.unify(set.sources, ['a\\\\/b', 'c+', 'd', '(?<x>e)'])"));
+		eval(t.TEST("t.unify(set.match('a/bccde'), [0, 1, 2, 3])"));
+
+		set = new RE2.Set([]);
+
+		eval(t.TEST("set.size === 0"));
+		eval(t.TEST("t.unify(set.match('abc'), [])"));
+		eval(t.TEST("!set.test('abc')"));
+	},
+	function test_setInvalid(t) {
+		"use strict";
+
+		try {
+			var set = new RE2.Set(["a", "("]);
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof SyntaxError"));
+		}
+
+		try {
+			var set = new RE2.Set("a");
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+
+		try {
+			var set = new RE2.Set(["a"], {anchor: "end"});
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+	},
+	function test_setIsNotRE2(t) {
+		"use strict";
+
+		try {
+			var re = new RE2(new RE2.Set(["a"]));
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+	}
+]);
@@ -0,0 +1,186 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// tests
+
+unit.add(module, [
+	function test_share(t) {
+		"use strict";
+
+		var re = new RE2("(\\w+)@(\\w+)\\.com", "gi"), handle = re.share();
+
+		eval(t.TEST("typeof handle.sharedId == 'number'"));
+		eval(t.TEST("handle.source === re.source"));
+		eval(t.TEST("handle.flags === re.flags"));
+		eval(t.TEST("handle.pattern === re.internalSource"));
+		eval(t.TEST("re.share().sharedId === handle.sharedId"));
+
+		var copy = new RE2(handle);
+		eval(t.TEST("copy instanceof RE2"));
+		eval(t.TEST("copy.source === re.source"));
+		eval(t.TEST("copy.flags === re.flags"));
+		eval(t.TEST("copy.lastIndex === 0"));
+		eval(t.TEST("copy.exec('Mail: Bob@Example.com')[1] === 'Bob'"));
+		eval(t.TEST("copy.lastIndex === 21"));
+		eval(t.TEST("re.lastIndex === 0"));
+
+		// flags can be overridden
+		var sticky = new RE2(handle, "y");
+		eval(t.TEST("sticky.flags === 'uy'"));
+		eval(t.TEST("!sticky.test('bob@example.com')"));
+	},
+	function test_shareReusesProgram(t) {
+		"use strict";
+
+		var capacity = RE2.cacheCapacity;
+		RE2.cacheCapacity = 0;
+
+		var re = new RE2("share-(\\d+)-program"), handle = re.share();
+
+		var before = RE2.getCacheStats();
+		var copy = new RE2(handle);
+		var after = RE2.getCacheStats();
+		eval(t.TEST("after.misses === before.misses"));
+		eval(t.TEST("copy.test('share-42-program')"));
+
+		// handles survive structured cloning, here imitated with JSON
+		var cloned = new RE2(JSON.parse(JSON.stringify(handle)));
+		eval(t.TEST("RE2.getCacheStats().misses === after.misses"));
+		eval(t.TEST("cloned.exec('x share-7-program')[1] === '7'"));
+
+		RE2.cacheCapacity = capacity;
+	},
+	function test_shareReleased(t) {
+		"use strict";
+
+		// a released program is compiled again from the handle
+		var handle = new RE2("a+?", "i", {longestMatch: true}).share();
+		handle.sharedId = 0;
+
+		var re = new RE2(handle);
+		eval(t.TEST("handle.options.longestMatch === true"));
+		eval(t.TEST("re.source === 'a+?'"));
+		eval(t.TEST("re.flags === 'iu'"));
+		eval(t.TEST("re.exec('xAaAy')[0] === 'AaA'"));
+
+		try {
+			var re2 = new RE2({sharedId: "oops"});
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+	},
+	function test_shareForged(t) {
+		"use strict";
+
+		// a handle is trusted only, when it describes its program
+		var handle = new RE2("forged-\\d+").share();
+
+		var re = new RE2({sharedId: handle.sharedId, source: "x", flags: "", pattern: "abc"});
+		eval(t.TEST("re.source === 'x'"));
+		eval(t.TEST("re.internalSource === 'abc'"));
+		eval(t.TEST("re.test('abc') && !re.test('forged-1')"));
+
+		// different options require a different program
+		var forged = JSON.parse(JSON.stringify(handle));
+		forged.options.longestMatch = true;
+		var before = RE2.getCacheStats();
+		var longest = new RE2(forged);
+		eval(t.TEST("RE2.getCacheStats().misses === before.misses + 1"));
+		eval(t.TEST("longest.test('forged-1')"));
+	},
+	function test_shareWorker(t) {
+		"use strict";
+
+		var workers;
+		try {
+			workers = require("worker_threads");
+		} catch (e) {
+			return; // worker threads are not available
+		}
+
+		var x = t.startAsync("test_shareWorker");
+
+		var re = new RE2("(?P<key>\\w+)=(?P<value>\\d+)", "g"),
+			worker = new workers.Worker(
+				"var re2 = require(" + JSON.stringify(require.resolve("../re2")) + ");" +
+				"var parentPort = require('worker_threads').parentPort;" +
+				"parentPort.on('message', function (handle) {" +
+				"  var re = new re2(handle);" +
+				"  parentPort.postMessage(re.match('a=1, b=22, c=x'));" +
+				"});",
+				{eval: true}
+			);
+
+		worker.on("message", function (result) {
+			eval(t.TEST("t.unify(result, ['a=1', 'b=22'])"));
+			worker.terminate();
+			x.done();
+		});
+		worker.postMessage(re.share());
+	},
+	function test_workerTeardown(t) {
+		"use strict";
+
+		var workers;
+		try {
+			workers = require("worker_threads");
+		} catch (e) {
+			return; // worker threads are not available
+		}
+
+		var x = t.startAsync("test_workerTeardown");
+
+		// objects, which are alive, when a worker exits, are freed by the environment cleanup
+		var re = new RE2("\\d+", "g"),
+			worker = new workers.Worker(
+				"var re2 = require(" + JSON.stringify(require.resolve("../re2")) + ");" +
+				"var handle = require('worker_threads').workerData;" +
+				"global.keep = [new re2(handle), new re2.Set(['a', 'b']), new re2(handle).execLazy('x 12'), new re2(handle).matchAll('1 2 3')," +
+				"  new re2(handle).createScanner()];" +
+				"global.keep[1].test('a');",
+				{eval: true, workerData: re.share()}
+			);
+
+		worker.on("exit", function (code) {
+			eval(t.TEST("code === 0"));
+			eval(t.TEST("t.unify(re.match('1 22 333'), ['1', '22', '333'])"));
+			x.done();
+		});
+	},
+	function test_reloadAddon(t) {
+		"use strict";
+
+		var workers;
+		try {
+			workers = require("worker_threads");
+		} catch (e) {
+			return; // worker threads are not available
+		}
+
+		var x = t.startAsync("test_reloadAddon");
+
+		// the addon is initialized again in the same environment, when it is removed from require.cache
+		var path = JSON.stringify(require.resolve("../re2")),
+			worker = new workers.Worker(
+				"var first = require(" + path + ");" +
+				"Object.keys(require.cache).forEach(function (name) { delete require.cache[name]; });" +
+				"var second = require(" + path + ");" +
+				"global.keep = [new first('a'), new second('b')];" +
+				"require('worker_threads').parentPort.postMessage(global.keep[1].test('abc'));",
+				{eval: true}
+			);
+
+		var result = null;
+		worker.on("message", function (value) { result = value; });
+		worker.on("exit", function (code) {
+			eval(t.TEST("code === 0"));
+			eval(t.TEST("result === true"));
+			x.done();
+		});
+	}
+]);
@@ -0,0 +1,97 @@
+"use strict";
+
+
+var unit = require("heya-unit");
+var RE2  = require("../re2");
+
+
+// tests
+
+unit.add(module, [
+	function test_statsCollect(t) {
+		"use strict";
+
+		var re = new RE2("b+", "g");
+
+		RE2.collectStats = false;
+		re.test("abc");
+		eval(t.TEST("re.stats().matches === 0"));
+
+		var before = RE2.stats();
+		RE2.collectStats = true;
+		eval(t.TEST("RE2.collectStats === true"));
+
+		re.test("abc");
+		"abbc".replace(re, "x"); // two calls: a match, and a failed search for the next one
+		re.exec("xyz");
+
+		var stats = re.stats();
+		eval(t.TEST("stats.matches === 4"));
+		eval(t.TEST("stats.bytes === 3 + 4 + 1 + 3"));
+		eval(t.TEST("typeof stats.time == 'number' && stats.time >= 0"));
+		eval(t.TEST("stats.slowMatches === 0"));
+
+		var after = RE2.stats();
+		eval(t.TEST("after.matches === before.matches + 4"));
+		eval(t.TEST("after.bytes === before.bytes + 11"));
+
+		// a clone has its own counters
+		eval(t.TEST("new RE2(re).stats().matches === 0"));
+
+		RE2.collectStats = false;
+	},
+	function test_statsSlowMatch(t) {
+		"use strict";
+
+		var x = t.startAsync("test_statsSlowMatch");
+
+		var threshold = RE2.slowMatchThreshold;
+		eval(t.TEST("typeof threshold == 'number'"));
+		try {
+			RE2.slowMatchThreshold = -1;
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof RangeError"));
+		}
+		try {
+			RE2.onSlowMatch = 42;
+			t.test(false); // shouldn't be here
+		} catch(e) {
+			eval(t.TEST("e instanceof TypeError"));
+		}
+
+		var re = new RE2("(a|b)*c", "i"), input = new Array(4097).join("ab");
+
+		// the hook is unreferenced, so keep the process alive until it is called
+		var timeout = setTimeout(function () {
+			t.test(false); // the hook was not called
+			finish();
+		}, 5000);
+
+		function finish() {
+			clearTimeout(timeout);
+			RE2.onSlowMatch = null;
+			RE2.slowMatchThreshold = threshold;
+			RE2.collectStats = false;
+			x.done();
+		}
+
+		RE2.onSlowMatch = function (info) {
+			eval(t.TEST("info.source === '(a|b)*c'"));
+			eval(t.TEST("info.flags === 'iu'"));
+			eval(t.TEST("info.size === input.length"));
+			eval(t.TEST("typeof info.time == 'number'"));
+			eval(t.TEST("re.stats().slowMatches === 1"));
+			finish();
+		};
+		eval(t.TEST("typeof RE2.onSlowMatch == 'function'"));
+
+		// every long enough scan is slow with a zero threshold
+		RE2.slowMatchThreshold = 0;
+		RE2.collectStats = true;
+		re.test("abc");
+		eval(t.TEST("re.stats().slowMatches === 0"));
+		re.test(input);
+		RE2.collectStats = false;
+	}
+]);
@@ -209,5 +209,77 @@ unit.add(module, [
 
 		eval(t.TEST("re2.test('Hello world, how are you?')"));
 		eval(t.TEST("re2.lastIndex === 6"));
+	},
+
+	// Hot loops: optimized code can take a fast path with one-byte strings
+
+	function test_testHotLoop(t) {
+		"use strict";
+
+		var re = new RE2("é+", "g"), ascii = new RE2("b+"), results = [];
+
+		for (var i = 0; i < 100000; ++i) {
+			// one-byte strings: ASCII, and Latin-1, which needs a conversion
+			if (!ascii.test("aabba") || ascii.test("aaa")) {
+				results.push("ascii");
+				break;
+			}
+			re.lastIndex = 0;
+			if (!re.test("caféé, café") || re.lastIndex !== 5 || !re.test("caféé, café") || re.lastIndex !== 11 ||
+					re.test("caféé, café") || re.lastIndex !== 0) {
+				results.push("latin1");
+				break;
+			}
+		}
+
+		eval(t.TEST("results.length === 0"));
+	},
+	function test_testStringShapes(t) {
+		"use strict";
+
+		// ASCII strings can be used in place: concatenated and sliced strings are flattened first
+		var prefix = new Array(100).join("x"), cons = prefix + "-needle-" + prefix, sliced = cons.slice(90, 120);
+		var re = new RE2("-needle-"), set = new RE2.Set(["needle", "é", "^$"]);
+
+		eval(t.TEST("re.test(cons) && re.test(sliced) && !re.test(prefix)"));
+		eval(t.TEST("re.search(cons) === 99 && re.search(sliced) === 9"));
+		eval(t.TEST("t.unify(set.match(sliced), [0])"));
+		eval(t.TEST("t.unify(set.match('café'), [1])"));
+		eval(t.TEST("t.unify(set.match(''), [2])"));
+		eval(t.TEST("set.test('naïve needle 😀')"));
+	},
+	function test_testFastCall(t) {
+		"use strict";
+
+		if (!("fastCalls" in RE2.stats())) {
+			return; // the addon is built without fast API calls
+		}
+
+		// optimize a caller explicitly, and check that V8 called the fast version
+		require("v8").setFlagsFromString("--allow-natives-syntax");
+		var prepare  = new Function("f", "%PrepareFunctionForOptimization(f);"),
+			optimize = new Function("f", "%OptimizeFunctionOnNextCall(f);");
+
+		function check(re, str) { return re.test(str); }
+
+		var ascii = new RE2("b+"), latin1 = new RE2("é+", "g");
+
+		RE2.collectStats = true;
+		prepare(check);
+		check(ascii, "abc");
+		check(ascii, "xyz");
+		optimize(check);
+
+		var before = RE2.stats().fastCalls;
+		eval(t.TEST("check(ascii, 'abc') === true"));
+		eval(t.TEST("check(ascii, 'xyz') === false"));
+		eval(t.TEST("check(latin1, 'caféé, café') === true && latin1.lastIndex === 5"));
+		eval(t.TEST("check(latin1, 'caféé, café') === true && latin1.lastIndex === 11"));
+		eval(t.TEST("check(latin1, 'caféé, café') === false && latin1.lastIndex === 0"));
+		var after = RE2.stats().fastCalls;
+		RE2.collectStats = false;
+
+		eval(t.TEST("after > before"));
+		eval(t.TEST("ascii.stats().fastCalls > 0"));
 	}
 ]);
@@ -6,9 +6,15 @@ var unit = require("heya-unit");
 require("./test_general");
 require("./test_source");
 require("./test_exec");
+require("./test_execInto");
+require("./test_execLazy");
 require("./test_test");
 require("./test_toString");
 require("./test_match");
+require("./test_matchAll");
+require("./test_matchAllParallel");
+require("./test_scanner");
+require("./test_scanFile");
 require("./test_replace");
 require("./test_search");
 require("./test_split");
@@ -17,5 +23,13 @@ require("./test_symbols");
 require("./test_prototype");
 require("./test_new");
 require("./test_groups");
+require("./test_set");
+require("./test_filtered_set");
+require("./test_many");
+require("./test_async");
+require("./test_cache");
+require("./test_share");
+require("./test_options");
+require("./test_stats");
 
 unit.run();